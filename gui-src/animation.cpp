@@ -0,0 +1,542 @@
+#include "animation.h"
+#include "bake.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <cmath>
+
+// frame time beyond this is dropped rather than simulated, so a long stall can't queue up
+// thousands of catch-up steps
+#define MAX_FRAME_TIME 0.25
+
+float wrapAngle(float angle)
+{
+	if ( angle >= 180.0f )
+	{
+		angle -= 360.0f;
+	}
+	else if ( angle < -180.0f )
+	{
+		angle += 360.0f;
+	}
+	return angle;
+}
+
+static float remainingAngle(float diff, float dir)
+{
+	// the direction can take the long way round, in which case the distance wraps
+	return diff * dir >= 0.0f ? fabsf(diff) : 360.0f - fabsf(diff);
+}
+
+float lerpAngle(float from, float to, float t)
+{
+	// interpolate along the shorter arc so poses either side of +-180 don't spin the long way
+	float diff = wrapAngle(to - from);
+	return wrapAngle(from + diff * t);
+}
+
+static void sequenceAxes(EulerMode eulerMode, int order[3])
+{
+	// the axes are aligned in the reverse of the order the rotations are applied
+	switch ( eulerMode )
+	{
+	case EULER_MODE_XYZ:
+		order[0] = AXIS_Z;
+		order[1] = AXIS_Y;
+		order[2] = AXIS_X;
+		break;
+	case EULER_MODE_XZY:
+		order[0] = AXIS_Y;
+		order[1] = AXIS_Z;
+		order[2] = AXIS_X;
+		break;
+	case EULER_MODE_YXZ:
+		order[0] = AXIS_Z;
+		order[1] = AXIS_X;
+		order[2] = AXIS_Y;
+		break;
+	case EULER_MODE_YZX:
+		order[0] = AXIS_X;
+		order[1] = AXIS_Z;
+		order[2] = AXIS_Y;
+		break;
+	case EULER_MODE_ZXY:
+		order[0] = AXIS_Y;
+		order[1] = AXIS_X;
+		order[2] = AXIS_Z;
+		break;
+	case EULER_MODE_ZYX:
+	default:
+		order[0] = AXIS_X;
+		order[1] = AXIS_Y;
+		order[2] = AXIS_Z;
+		break;
+	}
+}
+
+static void axisTravel(const Transition* transition, float dir[3], float distance[3])
+{
+	for ( int ai = 0; ai < 3; ++ai )
+	{
+		float diff = transition->target[ai] - transition->start[ai];
+		dir[ai] = diff >= 180.0f ? -1.0f : (diff < 0.0f ? -1.0f : 1.0f);
+		distance[ai] = (diff <= ANGLE_EPSILON && diff >= -ANGLE_EPSILON) ? 0.0f : remainingAngle(diff, dir[ai]);
+	}
+}
+
+void makeTransition(Transition* transition, const float start[3], const float target[3], float rotationDegPerSecond, AnimationMode mode, EulerMode eulerMode, EasingCurve easing, const BezierEasing* bezier)
+{
+	for ( int ai = 0; ai < 3; ++ai )
+	{
+		transition->start[ai] = wrapAngle(start[ai]);
+		transition->target[ai] = wrapAngle(target[ai]);
+	}
+	transition->rotationDegPerSecond = rotationDegPerSecond;
+	transition->mode = mode;
+	transition->eulerMode = eulerMode;
+	transition->easing = easing;
+	transition->bezier = bezier;
+}
+
+bool isSameTransition(const Transition* a, const Transition* b)
+{
+	for ( int ai = 0; ai < 3; ++ai )
+	{
+		if ( a->start[ai] != b->start[ai] || a->target[ai] != b->target[ai] )
+		{
+			return false;
+		}
+	}
+	return a->rotationDegPerSecond == b->rotationDegPerSecond && a->mode == b->mode && a->eulerMode == b->eulerMode && a->easing == b->easing && a->bezier == b->bezier;
+}
+
+double transitionDuration(const Transition* transition)
+{
+	float dir[3], distance[3];
+	axisTravel(transition, dir, distance);
+
+	double total = transition->mode == ANIMATION_SEQUENTIAL ?
+		(double)distance[0] + distance[1] + distance[2] :
+		(double)fmaxf(distance[0], fmaxf(distance[1], distance[2]));
+
+	if ( total <= 0.0 )
+	{
+		return 0.0;
+	}
+	if ( transition->rotationDegPerSecond <= 0.0f )
+	{
+		return INFINITY;
+	}
+	return total / transition->rotationDegPerSecond;
+}
+
+// how far through the transition the time is, before easing, in [0, 1]
+static double linearProgress(double time, double duration)
+{
+	double progress = duration > 0.0 ? time / duration : 1.0;
+	return progress < 0.0 ? 0.0 : (progress > 1.0 ? 1.0 : progress);
+}
+
+// the pose at an eased progress; arrived is whether the linear progress reached the end, as eased
+// progress can overshoot or fall short of it
+static void poseAtProgress(const Transition* transition, double progress, bool arrived, float rotation[3])
+{
+	float dir[3], distance[3];
+	axisTravel(transition, dir, distance);
+
+	if ( transition->mode == ANIMATION_SEQUENTIAL )
+	{
+		// each axis moves once the axes before it have arrived
+		int order[3];
+		sequenceAxes(transition->eulerMode, order);
+		double total = (double)distance[0] + distance[1] + distance[2];
+		double travelled = progress > 0.0 ? total * progress : 0.0;
+		for ( int oi = 0; oi < 3; ++oi )
+		{
+			int axis = order[oi];
+			if ( travelled >= distance[axis] )
+			{
+				rotation[axis] = transition->target[axis];
+			}
+			else
+			{
+				rotation[axis] = wrapAngle(transition->start[axis] + dir[axis] * (float)travelled);
+			}
+			travelled = travelled > distance[axis] ? travelled - distance[axis] : 0.0;
+		}
+	}
+	else
+	{
+		// every axis covers the same fraction of its distance, so they all arrive together
+		for ( int ai = 0; ai < 3; ++ai )
+		{
+			rotation[ai] = arrived ?
+				transition->target[ai] :
+				wrapAngle(transition->start[ai] + dir[ai] * distance[ai] * (float)progress);
+		}
+	}
+}
+
+void sampleTransition(const Transition* transition, double time, float rotation[3])
+{
+	// how far through the transition the time is, reshaped by the easing curve
+	double progress = linearProgress(time, transitionDuration(transition));
+	bool arrived = progress >= 1.0;
+	if ( transition->easing != EASING_LINEAR && !arrived )
+	{
+		progress = ease(easingTable(transition->easing, transition->bezier), (float)progress);
+	}
+	poseAtProgress(transition, progress, arrived, rotation);
+}
+
+void resetClock(AnimationClock* clock)
+{
+	clock->accumulator = 0.0;
+	clock->step = 0;
+	clock->running = false;
+}
+
+double stepDuration(const AnimationClock* clock)
+{
+	int stepRate = clock->stepRate < MIN_STEP_RATE ? MIN_STEP_RATE : (clock->stepRate > MAX_STEP_RATE ? MAX_STEP_RATE : clock->stepRate);
+	return 1.0 / (double)stepRate;
+}
+
+double clockTime(const AnimationClock* clock)
+{
+	return (double)clock->step * stepDuration(clock) + clock->accumulator;
+}
+
+bool isClockCurrent(const AnimationClock* clock, const Gimbal* gimbal, const float target[3], float rotationDegPerSecond, AnimationMode mode)
+{
+	if ( !clock->running )
+	{
+		return false;
+	}
+
+	for ( int ai = 0; ai < 3; ++ai )
+	{
+		if ( gimbal->rotation[ai] != clock->presented[ai] || wrapAngle(target[ai]) != clock->transition.target[ai] )
+		{
+			return false;
+		}
+	}
+
+	return rotationDegPerSecond == clock->transition.rotationDegPerSecond &&
+		mode == clock->transition.mode &&
+		clock->easing == clock->transition.easing &&
+		clock->bezier == clock->transition.bezier &&
+		gimbal->eulerMode == clock->transition.eulerMode;
+}
+
+void tickClock(AnimationClock* clock, float frameTime)
+{
+	double dt = stepDuration(clock);
+	clock->accumulator += frameTime > MAX_FRAME_TIME ? MAX_FRAME_TIME : (double)frameTime;
+	long long steps = (long long)(clock->accumulator / dt);
+	clock->step += steps;
+	clock->accumulator -= (double)steps * dt;
+}
+
+static void presentClock(AnimationClock* clock, Gimbal* gimbal)
+{
+	// show the pose part way between the steps either side of the clock time
+	double dt = stepDuration(clock);
+	float current[3], next[3];
+	const BakedAnimation* baked = clock->bakeCache ? findBaked(clock->bakeCache, &clock->transition) : nullptr;
+	if ( baked )
+	{
+		sampleBaked(baked, (double)clock->step * dt, current);
+		sampleBaked(baked, (double)(clock->step + 1) * dt, next);
+	}
+	else
+	{
+		sampleTransition(&clock->transition, (double)clock->step * dt, current);
+		sampleTransition(&clock->transition, (double)(clock->step + 1) * dt, next);
+	}
+
+	float alpha = (float)(clock->accumulator / dt);
+	for ( int ai = 0; ai < 3; ++ai )
+	{
+		clock->presented[ai] = lerpAngle(current[ai], next[ai], alpha);
+		gimbal->rotation[ai] = clock->presented[ai];
+	}
+}
+
+bool advanceClock(AnimationClock* clock, Gimbal* gimbal, const float target[3], float rotationDegPerSecond, AnimationMode mode, float frameTime)
+{
+	// start a new transition from the gimbal if this is the first frame or anything was edited
+	if ( !isClockCurrent(clock, gimbal, target, rotationDegPerSecond, mode) )
+	{
+		makeTransition(&clock->transition, gimbal->rotation, target, rotationDegPerSecond, mode, gimbal->eulerMode, clock->easing, clock->bezier);
+		clock->accumulator = 0.0;
+		clock->step = 0;
+		clock->running = true;
+	}
+
+	tickClock(clock, frameTime);
+
+	double dt = stepDuration(clock);
+	double duration = transitionDuration(&clock->transition);
+	if ( (double)clock->step * dt >= duration )
+	{
+		// park the clock on the end so the finished transition can still be scrubbed
+		clock->step = (long long)(duration / dt);
+		clock->accumulator = duration - (double)clock->step * dt;
+		for ( int ai = 0; ai < 3; ++ai )
+		{
+			clock->presented[ai] = clock->transition.target[ai];
+			gimbal->rotation[ai] = clock->transition.target[ai];
+		}
+		return true;
+	}
+
+	presentClock(clock, gimbal);
+	return false;
+}
+
+void seekClock(AnimationClock* clock, Gimbal* gimbal, double time)
+{
+	if ( !clock->running )
+	{
+		return;
+	}
+
+	double dt = stepDuration(clock);
+	double duration = transitionDuration(&clock->transition);
+	time = time < 0.0 ? 0.0 : (time > duration ? duration : time);
+	clock->step = (long long)(time / dt);
+	clock->accumulator = time - (double)clock->step * dt;
+	presentClock(clock, gimbal);
+}
+
+size_t batchSize(const AnimationBatch* batch)
+{
+	return batch->time.size();
+}
+
+static void batchTransition(const AnimationBatch* batch, size_t index, Transition* transition)
+{
+	transition->start[AXIS_X] = batch->startX[index];
+	transition->start[AXIS_Y] = batch->startY[index];
+	transition->start[AXIS_Z] = batch->startZ[index];
+	transition->target[AXIS_X] = batch->targetX[index];
+	transition->target[AXIS_Y] = batch->targetY[index];
+	transition->target[AXIS_Z] = batch->targetZ[index];
+	transition->rotationDegPerSecond = batch->rotationDegPerSecond;
+	transition->mode = batch->mode;
+	transition->easing = batch->easing;
+	transition->bezier = batch->bezier;
+	transition->eulerMode = (EulerMode)batch->eulerMode[index];
+}
+
+static void startBatchEntry(AnimationBatch* batch, size_t index, const float start[3], const float target[3], EulerMode eulerMode)
+{
+	// build each transition the same way the single gimbal path does
+	Transition transition;
+	makeTransition(&transition, start, target, batch->rotationDegPerSecond, batch->mode, eulerMode, batch->easing, batch->bezier);
+	batch->startX[index] = transition.start[AXIS_X];
+	batch->startY[index] = transition.start[AXIS_Y];
+	batch->startZ[index] = transition.start[AXIS_Z];
+	batch->targetX[index] = transition.target[AXIS_X];
+	batch->targetY[index] = transition.target[AXIS_Y];
+	batch->targetZ[index] = transition.target[AXIS_Z];
+	batch->rotationX[index] = transition.start[AXIS_X];
+	batch->rotationY[index] = transition.start[AXIS_Y];
+	batch->rotationZ[index] = transition.start[AXIS_Z];
+	batch->eulerMode[index] = (unsigned char)transition.eulerMode;
+	batch->time[index] = 0.0;
+	batch->duration[index] = transitionDuration(&transition);
+
+	setBit(&batch->dirty, index);
+	if ( batch->duration[index] > 0.0 )
+	{
+		setBit(&batch->active, index);
+	}
+	else
+	{
+		clearBit(&batch->active, index);
+	}
+}
+
+void loadBatch(AnimationBatch* batch, const Gimbal* gimbals, const Gimbal* targets, size_t count, float rotationDegPerSecond, AnimationMode mode, EasingCurve easing, const BezierEasing* bezier)
+{
+	std::vector<float>* columns[] = {
+		&batch->startX, &batch->startY, &batch->startZ,
+		&batch->targetX, &batch->targetY, &batch->targetZ,
+		&batch->rotationX, &batch->rotationY, &batch->rotationZ
+	};
+	for ( std::vector<float>* column : columns )
+	{
+		column->resize(count);
+	}
+	batch->time.resize(count);
+	batch->duration.resize(count);
+	batch->eulerMode.resize(count);
+	batch->waypoints.assign(count, nullptr);
+	batch->queued.clear();
+	resizeBits(&batch->active, count);
+	resizeBits(&batch->dirty, count);
+	batch->rotationDegPerSecond = rotationDegPerSecond;
+	batch->mode = mode;
+	batch->easing = easing;
+	batch->bezier = bezier;
+
+	for ( size_t gi = 0; gi < count; ++gi )
+	{
+		startBatchEntry(batch, gi, gimbals[gi].rotation, targets[gi].rotation, gimbals[gi].eulerMode);
+	}
+}
+
+void retargetBatch(AnimationBatch* batch, size_t index, const float target[3])
+{
+	float pose[3] = { batch->rotationX[index], batch->rotationY[index], batch->rotationZ[index] };
+	startBatchEntry(batch, index, pose, target, (EulerMode)batch->eulerMode[index]);
+}
+
+void restartBatch(AnimationBatch* batch, size_t index, const float start[3])
+{
+	float target[3] = { batch->targetX[index], batch->targetY[index], batch->targetZ[index] };
+	startBatchEntry(batch, index, start, target, (EulerMode)batch->eulerMode[index]);
+}
+
+void setBatchSettings(AnimationBatch* batch, float rotationDegPerSecond, AnimationMode mode, EasingCurve easing)
+{
+	batch->rotationDegPerSecond = rotationDegPerSecond;
+	batch->mode = mode;
+	batch->easing = easing;
+	forEachBit(&batch->active, 0, batch->active.words.size(), [batch](size_t gi)
+	{
+		float target[3] = { batch->targetX[gi], batch->targetY[gi], batch->targetZ[gi] };
+		retargetBatch(batch, gi, target);
+	});
+}
+
+void attachWaypoints(AnimationBatch* batch, size_t index, WaypointQueue* queue)
+{
+	if ( batch->waypoints[index] == nullptr && queue != nullptr )
+	{
+		batch->queued.push_back(index);
+	}
+	else if ( batch->waypoints[index] != nullptr && queue == nullptr )
+	{
+		batch->queued.erase(std::find(batch->queued.begin(), batch->queued.end(), index));
+	}
+	batch->waypoints[index] = queue;
+}
+
+static bool nextWaypoint(AnimationBatch* batch, size_t index)
+{
+	float target[3];
+	WaypointQueue* queue = batch->waypoints[index];
+	if ( queue == nullptr || !popWaypoint(queue, target) )
+	{
+		return false;
+	}
+	retargetBatch(batch, index, target);
+	return true;
+}
+
+// poses a block of running entries: their progress is gathered into a column and eased in one
+// pass, so the easing table stays in cache and the loop carries no per entry branch on the curve
+static void animateBlock(AnimationBatch* batch, double frameTime, const size_t* indices, size_t count)
+{
+	double progress[BATCH_EASE_BLOCK];
+	float linear[BATCH_EASE_BLOCK];
+	float eased[BATCH_EASE_BLOCK];
+	for ( size_t li = 0; li < count; ++li )
+	{
+		size_t gi = indices[li];
+		batch->time[gi] += frameTime;
+		progress[li] = linearProgress(batch->time[gi], batch->duration[gi]);
+		linear[li] = (float)progress[li];
+	}
+	if ( batch->easing != EASING_LINEAR )
+	{
+		easeColumns(easingTable(batch->easing, batch->bezier), count, linear, eased);
+	}
+
+	for ( size_t li = 0; li < count; ++li )
+	{
+		size_t gi = indices[li];
+		Transition transition;
+		batchTransition(batch, gi, &transition);
+
+		// the same pose sampleTransition gives, eased only until arrival
+		bool arrived = progress[li] >= 1.0;
+		float rotation[3];
+		poseAtProgress(&transition, batch->easing != EASING_LINEAR && !arrived ? (double)eased[li] : progress[li], arrived, rotation);
+		batch->rotationX[gi] = rotation[AXIS_X];
+		batch->rotationY[gi] = rotation[AXIS_Y];
+		batch->rotationZ[gi] = rotation[AXIS_Z];
+
+		setBit(&batch->dirty, gi);
+		if ( batch->time[gi] >= batch->duration[gi] && !nextWaypoint(batch, gi) )
+		{
+			clearBit(&batch->active, gi);
+		}
+	}
+}
+
+static void animateWords(AnimationBatch* batch, double frameTime, size_t beginWord, size_t endWord)
+{
+	// a chunk owns whole words of the flags, so workers never write the same word; the walk reads
+	// each word before visiting its bits, so entries finishing within a block don't disturb it
+	size_t indices[BATCH_EASE_BLOCK];
+	size_t count = 0;
+	forEachBit(&batch->active, beginWord, endWord, [&](size_t gi)
+	{
+		indices[count++] = gi;
+		if ( count == BATCH_EASE_BLOCK )
+		{
+			animateBlock(batch, frameTime, indices, count);
+			count = 0;
+		}
+	});
+	animateBlock(batch, frameTime, indices, count);
+}
+
+size_t animateBatch(AnimationBatch* batch, float frameTime, ThreadPool* pool)
+{
+	// wake resting entries that have been given somewhere to go
+	for ( size_t gi : batch->queued )
+	{
+		if ( !testBit(&batch->active, gi) )
+		{
+			nextWaypoint(batch, gi);
+		}
+	}
+
+	size_t words = batch->active.words.size();
+	size_t running = countBits(&batch->active);
+
+	// too few moving to be worth waking the workers
+	if ( pool == nullptr || running < BATCH_CHUNK_SIZE )
+	{
+		animateWords(batch, frameTime, 0, words);
+	}
+	else
+	{
+		parallelFor(pool, words, BATCH_CHUNK_SIZE / BITS_PER_WORD, [batch, frameTime](size_t begin, size_t end)
+		{
+			animateWords(batch, frameTime, begin, end);
+		});
+	}
+	return countBits(&batch->active);
+}
+
+size_t storeBatch(AnimationBatch* batch, Gimbal* gimbals, size_t count)
+{
+	size_t stored = 0;
+	forEachBit(&batch->dirty, 0, batch->dirty.words.size(), [&](size_t gi)
+	{
+		if ( gi < count )
+		{
+			gimbals[gi].rotation[AXIS_X] = batch->rotationX[gi];
+			gimbals[gi].rotation[AXIS_Y] = batch->rotationY[gi];
+			gimbals[gi].rotation[AXIS_Z] = batch->rotationZ[gi];
+			++stored;
+		}
+	});
+	clearBits(&batch->dirty);
+	return stored;
+}
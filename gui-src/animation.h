@@ -0,0 +1,129 @@
+#pragma once
+#include "bitset.h"
+#include "easing.h"
+#include "gimbal.h"
+#include "waypoints.h"
+#include <cstddef>
+#include <vector>
+
+#define ANGLE_EPSILON 5e-2f
+#define MIN_STEP_RATE 10
+#define MAX_STEP_RATE 1000
+#define DEFAULT_STEP_RATE 240
+#define BATCH_CHUNK_SIZE 4096
+#define BATCH_EASE_BLOCK 256 // running entries eased together in one pass
+
+enum AnimationMode
+{
+	ANIMATION_SEQUENTIAL = 0,
+	ANIMATION_CONCURRENT = 1
+};
+
+// wraps an angle in degrees into [-180, 180)
+float wrapAngle(float angle);
+// interpolates between two angles in degrees along the shorter arc
+float lerpAngle(float from, float to, float t);
+
+// A rotation from a start pose to a target at a constant speed. Transitions are evaluated in
+// closed form, so the pose at any time is O(1) to compute and can be sampled in any order.
+//  - Sequential transitions align one axis at a time in the order given by the euler mode.
+//  - Concurrent transitions move every axis at once, scaled so they all arrive together.
+// The easing curve reshapes progress over the same duration, so an eased transition still arrives
+// when a linear one would.
+struct Transition
+{
+	Vec3 start;
+	Vec3 target;
+	float rotationDegPerSecond;
+	AnimationMode mode;
+	EulerMode eulerMode;
+	EasingCurve easing;
+	const BezierEasing* bezier; // the curve EASING_BEZIER follows, owned by whoever made the transition
+};
+
+void makeTransition(Transition* transition, const float start[3], const float target[3], float rotationDegPerSecond, AnimationMode mode, EulerMode eulerMode, EasingCurve easing, const BezierEasing* bezier);
+bool isSameTransition(const Transition* a, const Transition* b);
+// total time in seconds to reach the target, infinite if the speed is zero and there is anywhere to go
+double transitionDuration(const Transition* transition);
+void sampleTransition(const Transition* transition, double time, float rotation[3]);
+
+struct BakeCache;
+
+// Plays a transition on a fixed-rate clock independent of the frame rate. Frame time is
+// accumulated and consumed in whole steps, and the pose shown between steps is interpolated from
+// the steps either side, so the result is the same at 20 fps as at 240 fps.
+struct AnimationClock
+{
+	int stepRate;          // simulation steps per second
+	double accumulator;    // frame time not yet consumed by a step
+	long long step;        // steps taken since the transition started
+	Transition transition; // the transition being played
+	Vec3 presented;        // interpolated pose last written to the gimbal
+	bool running;          // whether the clock holds a transition, playing or paused
+	BakeCache* bakeCache;  // if set, transitions are baked and played back from the cache
+	EasingCurve easing;    // curve new transitions are eased with
+	const BezierEasing* bezier; // and the bezier they follow, if that is the curve
+};
+
+void resetClock(AnimationClock* clock);
+// length of one step in seconds
+double stepDuration(const AnimationClock* clock);
+// seconds into the transition the clock is at
+double clockTime(const AnimationClock* clock);
+// consumes frame time in whole steps, leaving the remainder in the accumulator
+void tickClock(AnimationClock* clock, float frameTime);
+// true if the clock holds a transition that still matches the gimbal, target and settings (including
+// the clock's easing), i.e.
+// nothing has been edited since the pose was last written
+bool isClockCurrent(const AnimationClock* clock, const Gimbal* gimbal, const float target[3], float rotationDegPerSecond, AnimationMode mode);
+// advances the clock by frameTime seconds and writes the interpolated pose to the gimbal, returns
+// true once the target has been reached; any edit starts a new transition from the gimbal's pose
+bool advanceClock(AnimationClock* clock, Gimbal* gimbal, const float target[3], float rotationDegPerSecond, AnimationMode mode, float frameTime);
+// jumps to a time within the current transition and writes the pose to the gimbal
+void seekClock(AnimationClock* clock, Gimbal* gimbal, double time);
+
+struct ThreadPool;
+
+// Many transitions stored column by column, for animating large populations of gimbals at once.
+// Chunks of the batch are contiguous in every column, so workers never share a cache line apart
+// from at chunk boundaries. Poses come from sampleTransition, so they match the single gimbal path.
+// Only entries flagged active are visited, and only those flagged dirty are written back, so a batch
+// where few gimbals move costs roughly in proportion to the ones that do.
+struct AnimationBatch
+{
+	std::vector<float> startX, startY, startZ;
+	std::vector<float> targetX, targetY, targetZ;
+	std::vector<float> rotationX, rotationY, rotationZ; // current poses
+	std::vector<double> time;                           // seconds into each transition
+	std::vector<double> duration;
+	std::vector<unsigned char> eulerMode;
+	BitSet active; // transitions still running
+	BitSet dirty;  // poses changed since they were last stored
+	std::vector<WaypointQueue*> waypoints; // queue each entry moves on to once at rest, if any
+	std::vector<size_t> queued;            // entries with a waypoint queue attached
+	float rotationDegPerSecond;
+	AnimationMode mode;
+	EasingCurve easing;
+	const BezierEasing* bezier;
+};
+
+size_t batchSize(const AnimationBatch* batch);
+// starts a transition from each gimbal's pose to its target
+void loadBatch(AnimationBatch* batch, const Gimbal* gimbals, const Gimbal* targets, size_t count, float rotationDegPerSecond, AnimationMode mode, EasingCurve easing, const BezierEasing* bezier);
+// starts a new transition for one entry from its current pose
+void retargetBatch(AnimationBatch* batch, size_t index, const float target[3]);
+// starts a new transition for one entry from a pose to its target, e.g. after its gimbal was edited
+void restartBatch(AnimationBatch* batch, size_t index, const float start[3]);
+// changes the speed, mode and easing of every entry, the running ones starting again from their
+// current poses as an edited single gimbal does; the entries at rest stay at rest
+void setBatchSettings(AnimationBatch* batch, float rotationDegPerSecond, AnimationMode mode, EasingCurve easing);
+// gives an entry a queue of targets to work through, each popped as the last one is reached; the
+// queue is owned by the caller and must outlive the batch or be detached by passing nullptr
+void attachWaypoints(AnimationBatch* batch, size_t index, WaypointQueue* queue);
+// advances the running transitions by frameTime seconds and samples their poses, split across the
+// pool if one is given; entries at rest with waypoints pending start towards the next one. Returns
+// how many transitions are still running
+size_t animateBatch(AnimationBatch* batch, float frameTime, ThreadPool* pool);
+// writes the poses that changed back to the gimbals and clears their dirty flags, gimbals left
+// untouched keep their draw caches; returns how many were written
+size_t storeBatch(AnimationBatch* batch, Gimbal* gimbals, size_t count);
@@ -0,0 +1,137 @@
+#include "bake.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+static size_t hashTransition(const Transition* transition)
+{
+	// FNV-1a over the fields, floats by their bit patterns to match isSameTransition
+	uint64_t hash = 14695981039346656037ull;
+	auto mix = [&hash](uint32_t value)
+	{
+		for ( int bi = 0; bi < 4; ++bi )
+		{
+			hash ^= (value >> (bi * 8)) & 0xffu;
+			hash *= 1099511628211ull;
+		}
+	};
+	auto mixFloat = [&mix](float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		mix(bits);
+	};
+
+	for ( int ai = 0; ai < 3; ++ai )
+	{
+		mixFloat(transition->start[ai]);
+		mixFloat(transition->target[ai]);
+	}
+	mixFloat(transition->rotationDegPerSecond);
+	mix((uint32_t)transition->mode);
+	mix((uint32_t)transition->eulerMode);
+	mix((uint32_t)transition->easing);
+	return (size_t)hash;
+}
+
+static size_t bakedSize(const BakedAnimation* baked)
+{
+	return baked->poses.size() * sizeof(BakedPose);
+}
+
+static void evict(BakeCache* cache, std::list<BakedAnimation>::iterator entry)
+{
+	cache->used -= bakedSize(&*entry);
+	cache->lookup.erase(hashTransition(&entry->transition));
+	cache->entries.erase(entry);
+}
+
+const BakedAnimation* findBaked(BakeCache* cache, const Transition* transition)
+{
+	size_t hash = hashTransition(transition);
+	auto found = cache->lookup.find(hash);
+	if ( found != cache->lookup.end() )
+	{
+		if ( isSameTransition(&found->second->transition, transition) )
+		{
+			// move to the front of the recently used list
+			cache->entries.splice(cache->entries.begin(), cache->entries, found->second);
+			return &*found->second;
+		}
+
+		// hash collision, the new transition takes the slot
+		evict(cache, found->second);
+	}
+
+	double duration = transitionDuration(transition);
+	if ( !std::isfinite(duration) )
+	{
+		return nullptr;
+	}
+
+	size_t count = (size_t)std::ceil(duration * BAKE_SAMPLE_RATE) + 1;
+	size_t size = count * sizeof(BakedPose);
+	if ( size > cache->budget )
+	{
+		return nullptr;
+	}
+
+	while ( cache->used + size > cache->budget && !cache->entries.empty() )
+	{
+		evict(cache, std::prev(cache->entries.end()));
+	}
+
+	cache->entries.emplace_front();
+	BakedAnimation* baked = &cache->entries.front();
+	baked->transition = *transition;
+	baked->duration = duration;
+	baked->poses.resize(count);
+	for ( size_t pi = 0; pi + 1 < count; ++pi )
+	{
+		sampleTransition(transition, (double)pi / BAKE_SAMPLE_RATE, baked->poses[pi].rotation);
+		baked->poses[pi].padding = 0.0f;
+	}
+	sampleTransition(transition, duration, baked->poses[count - 1].rotation);
+	baked->poses[count - 1].padding = 0.0f;
+
+	cache->used += size;
+	cache->lookup[hash] = cache->entries.begin();
+	return baked;
+}
+
+void sampleBaked(const BakedAnimation* baked, double time, float rotation[3])
+{
+	size_t last = baked->poses.size() - 1;
+	double position = time * BAKE_SAMPLE_RATE;
+	if ( position <= 0.0 || last == 0 )
+	{
+		memcpy(rotation, baked->poses[0].rotation, sizeof(float) * 3);
+		return;
+	}
+
+	size_t index = (size_t)position;
+	if ( time >= baked->duration || index >= last )
+	{
+		memcpy(rotation, baked->poses[last].rotation, sizeof(float) * 3);
+		return;
+	}
+
+	// the last interval is shorter than the others when the duration isn't a whole sample
+	double end = index + 1 == last ? baked->duration * BAKE_SAMPLE_RATE : (double)(index + 1);
+	float t = (float)((position - (double)index) / (end - (double)index));
+	t = t > 1.0f ? 1.0f : t;
+
+	const BakedPose& from = baked->poses[index];
+	const BakedPose& to = baked->poses[index + 1];
+	for ( int ai = 0; ai < 3; ++ai )
+	{
+		rotation[ai] = lerpAngle(from.rotation[ai], to.rotation[ai], t);
+	}
+}
+
+void clearBakeCache(BakeCache* cache)
+{
+	cache->entries.clear();
+	cache->lookup.clear();
+	cache->used = 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "animation.h"
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#define BAKE_SAMPLE_RATE 120
+#define DEFAULT_BAKE_BUDGET (16u * 1024u * 1024u)
+
+struct alignas(16) BakedPose
+{
+	float rotation[3];
+	float padding;
+};
+
+// A transition sampled at BAKE_SAMPLE_RATE into one contiguous buffer, the final pose is always
+// the target. Playing it back is a fetch of two neighbouring poses and a lerp.
+struct BakedAnimation
+{
+	Transition transition;
+	double duration;
+	std::vector<BakedPose> poses;
+};
+
+// Baked transitions keyed by everything that shapes them (start, target, speed, mode, euler
+// order and easing), evicted least recently used first once their poses exceed the memory budget.
+struct BakeCache
+{
+	size_t budget; // bytes of poses the cache may hold
+	size_t used;   // bytes of poses currently held
+	std::list<BakedAnimation> entries; // most recently used first
+	std::unordered_map<size_t, std::list<BakedAnimation>::iterator> lookup;
+};
+
+// returns the baked transition, baking it on a miss; returns nullptr if it can't be baked
+// (e.g. it never finishes or is larger than the whole budget)
+const BakedAnimation* findBaked(BakeCache* cache, const Transition* transition);
+void sampleBaked(const BakedAnimation* baked, double time, float rotation[3]);
+void clearBakeCache(BakeCache* cache);
@@ -0,0 +1,51 @@
+#include "bitset.h"
+
+#ifdef _MSC_VER
+	#define popCount(word) __popcnt64(word)
+#else
+	#define popCount(word) __builtin_popcountll(word)
+#endif
+
+void resizeBits(BitSet* bits, size_t count)
+{
+	bits->words.resize((count + BITS_PER_WORD - 1) / BITS_PER_WORD, 0);
+
+	// drop bits past the end that a larger set left behind
+	if ( count % BITS_PER_WORD != 0 )
+	{
+		bits->words.back() &= (1ull << (count % BITS_PER_WORD)) - 1;
+	}
+}
+
+void setBit(BitSet* bits, size_t index)
+{
+	bits->words[index / BITS_PER_WORD] |= 1ull << (index % BITS_PER_WORD);
+}
+
+void clearBit(BitSet* bits, size_t index)
+{
+	bits->words[index / BITS_PER_WORD] &= ~(1ull << (index % BITS_PER_WORD));
+}
+
+bool testBit(const BitSet* bits, size_t index)
+{
+	return (bits->words[index / BITS_PER_WORD] >> (index % BITS_PER_WORD)) & 1u;
+}
+
+void clearBits(BitSet* bits)
+{
+	for ( uint64_t& word : bits->words )
+	{
+		word = 0;
+	}
+}
+
+size_t countBits(const BitSet* bits)
+{
+	size_t count = 0;
+	for ( uint64_t word : bits->words )
+	{
+		count += (size_t)popCount(word);
+	}
+	return count;
+}
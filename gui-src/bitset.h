@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+#define BITS_PER_WORD 64
+
+// One bit per entry, packed 64 to a word. Walking the set bits skips 64 clear entries per word
+// read, so a set that is mostly clear costs little more than its set bits.
+struct BitSet
+{
+	std::vector<uint64_t> words;
+};
+
+void resizeBits(BitSet* bits, size_t count);
+void setBit(BitSet* bits, size_t index);
+void clearBit(BitSet* bits, size_t index);
+bool testBit(const BitSet* bits, size_t index);
+void clearBits(BitSet* bits);
+size_t countBits(const BitSet* bits);
+
+// index of the lowest set bit, the word must not be zero
+inline unsigned int lowestBit(uint64_t word)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return (unsigned int)index;
+#else
+	return (unsigned int)__builtin_ctzll(word);
+#endif
+}
+
+// calls func(index) for each set bit in the words [beginWord, endWord), in order
+template <typename Func>
+void forEachBit(const BitSet* bits, size_t beginWord, size_t endWord, Func func)
+{
+	for ( size_t wi = beginWord; wi < endWord; ++wi )
+	{
+		uint64_t word = bits->words[wi];
+		while ( word != 0 )
+		{
+			func(wi * BITS_PER_WORD + lowestBit(word));
+			word &= word - 1;
+		}
+	}
+}
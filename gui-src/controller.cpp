@@ -0,0 +1,46 @@
+#include "controller.h"
+
+void initController(Controller* controller, Gimbal* gimbal, Gimbal* target)
+{
+	controller->gimbal = gimbal;
+	controller->target = target;
+	resetSession(&controller->session);
+	clearWaypoints(&controller->waypoints);
+	controller->input = controller->session.settings;
+}
+
+void updateController(Controller* controller)
+{
+	// the session holds one waypoint at a time so a recording captures when each arrived
+	SessionInput* input = &controller->input;
+	if ( input->actions & ACTION_STOP )
+	{
+		// stopping drops the route as well, or the next waypoint would start it straight away
+		clearWaypoints(&controller->waypoints);
+	}
+	else if ( !controller->session.hasWaypoint && popWaypoint(&controller->waypoints, input->waypoint) )
+	{
+		input->actions |= ACTION_WAYPOINT;
+	}
+	applySession(&controller->session, input, controller->gimbal, controller->target);
+}
+
+void updateControllers(Controller* const* controllers, size_t count, ThreadPool* pool)
+{
+	if ( pool == nullptr )
+	{
+		for ( size_t ci = 0; ci < count; ++ci )
+		{
+			updateController(controllers[ci]);
+		}
+		return;
+	}
+
+	parallelFor(pool, count, 1, [controllers](size_t begin, size_t end)
+	{
+		for ( size_t ci = begin; ci < end; ++ci )
+		{
+			updateController(controllers[ci]);
+		}
+	});
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "session.h"
+#include "threadpool.h"
+#include "waypoints.h"
+#include <cstddef>
+
+// Everything that animates one primary and target pair. The panel fills in a controller's input
+// and updating it is a separate step, so any number of pairs can animate side by side, be
+// stepped together, and be stepped on threads other than the GUI's.
+struct Controller
+{
+	Gimbal* gimbal;
+	Gimbal* target;
+	Session session;
+	WaypointQueue waypoints; // targets queued for the primary once it reaches the current one
+	SessionInput input;      // the frame's input; after an update, what was applied
+};
+
+void initController(Controller* controller, Gimbal* gimbal, Gimbal* target);
+// applies the input, first taking the next waypoint from the queue if the session has room for it
+void updateController(Controller* controller);
+// Updates many controllers across the pool, each on one worker, or in turn without one. A
+// controller owns everything its update changes, its bezier curve and bake cache included, so
+// the only state they share is the easing tables built at startup.
+void updateControllers(Controller* const* controllers, size_t count, ThreadPool* pool);
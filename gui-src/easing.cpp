@@ -0,0 +1,161 @@
+#include "easing.h"
+#include <cmath>
+#include <cstring>
+
+#define PI 3.14159265358979323846
+// newton steps before falling back to bisection when inverting the bezier's x
+#define BEZIER_NEWTON_STEPS 8
+
+static EasingTable tables[EASING_COUNT];
+static const float defaultBezier[4] = { 0.25f, 0.1f, 0.25f, 1.0f }; // css 'ease'
+
+static double bezierAxis(double a, double b, double s)
+{
+	// one axis of a cubic bezier with end points 0 and 1
+	double r = 1.0 - s;
+	return 3.0 * r * r * s * a + 3.0 * r * s * s * b + s * s * s;
+}
+
+static double bezierSlope(double a, double b, double s)
+{
+	double r = 1.0 - s;
+	return 3.0 * r * r * a + 6.0 * r * s * (b - a) + 3.0 * s * s * (1.0 - b);
+}
+
+static double solveBezier(const float controls[4], double t)
+{
+	// find the curve parameter whose x is t, then return its y
+	double x1 = controls[0], y1 = controls[1];
+	double x2 = controls[2], y2 = controls[3];
+	double s = t;
+	for ( int ni = 0; ni < BEZIER_NEWTON_STEPS; ++ni )
+	{
+		double error = bezierAxis(x1, x2, s) - t;
+		double slope = bezierSlope(x1, x2, s);
+		if ( std::fabs(error) < 1e-7 )
+		{
+			return bezierAxis(y1, y2, s);
+		}
+		if ( std::fabs(slope) < 1e-6 )
+		{
+			break;
+		}
+		s -= error / slope;
+		if ( s < 0.0 || s > 1.0 )
+		{
+			break;
+		}
+	}
+
+	// x is monotonic in s while the control points stay within [0, 1]
+	double low = 0.0, high = 1.0;
+	s = t;
+	for ( int bi = 0; bi < 50; ++bi )
+	{
+		if ( bezierAxis(x1, x2, s) < t )
+		{
+			low = s;
+		}
+		else
+		{
+			high = s;
+		}
+		s = 0.5 * (low + high);
+	}
+	return bezierAxis(y1, y2, s);
+}
+
+static double evaluateCurve(EasingCurve curve, const float bezier[4], double t)
+{
+	switch ( curve )
+	{
+	case EASING_CUBIC:
+		return t < 0.5 ? 4.0 * t * t * t : 1.0 - std::pow(2.0 - 2.0 * t, 3.0) / 2.0;
+	case EASING_EXPONENTIAL:
+		if ( t <= 0.0 || t >= 1.0 )
+		{
+			return t <= 0.0 ? 0.0 : 1.0;
+		}
+		return t < 0.5 ? std::pow(2.0, 20.0 * t - 10.0) / 2.0 : (2.0 - std::pow(2.0, 10.0 - 20.0 * t)) / 2.0;
+	case EASING_ELASTIC:
+		if ( t <= 0.0 || t >= 1.0 )
+		{
+			return t <= 0.0 ? 0.0 : 1.0;
+		}
+		return std::pow(2.0, -10.0 * t) * std::sin((t * 10.0 - 0.75) * (2.0 * PI / 3.0)) + 1.0;
+	case EASING_BEZIER:
+		return solveBezier(bezier, t);
+	case EASING_LINEAR:
+	default:
+		return t;
+	}
+}
+
+static void buildTable(EasingTable* table, EasingCurve curve, const float bezier[4])
+{
+	for ( int si = 0; si <= EASING_TABLE_SIZE; ++si )
+	{
+		table->values[si] = (float)evaluateCurve(curve, bezier, (double)si / EASING_TABLE_SIZE);
+	}
+}
+
+static bool buildTables()
+{
+	for ( int curve = EASING_LINEAR; curve < EASING_COUNT; ++curve )
+	{
+		buildTable(&tables[curve], (EasingCurve)curve, defaultBezier);
+	}
+	return true;
+}
+
+// built before main, so looking a table up is only ever a read and pool workers can share them
+static const bool tablesBuilt = buildTables();
+
+const EasingTable* easingTable(EasingCurve curve, const BezierEasing* bezier)
+{
+	curve = curve >= EASING_LINEAR && curve < EASING_COUNT ? curve : EASING_LINEAR;
+	return curve == EASING_BEZIER && bezier != nullptr ? &bezier->table : &tables[curve];
+}
+
+void initBezierEasing(BezierEasing* bezier)
+{
+	memcpy(bezier->controls, defaultBezier, sizeof(bezier->controls));
+	bezier->table = tables[EASING_BEZIER];
+}
+
+bool setBezierEasing(BezierEasing* bezier, const float controls[4])
+{
+	bool changed = false;
+	float values[4];
+	for ( int ci = 0; ci < 4; ++ci )
+	{
+		// keep x within [0, 1] so the curve stays a function of progress
+		values[ci] = ci % 2 == 0 ? (controls[ci] < 0.0f ? 0.0f : (controls[ci] > 1.0f ? 1.0f : controls[ci])) : controls[ci];
+		changed = changed || values[ci] != bezier->controls[ci];
+	}
+
+	// the table is only rebuilt when the curve actually changes
+	if ( changed )
+	{
+		memcpy(bezier->controls, values, sizeof(bezier->controls));
+		buildTable(&bezier->table, EASING_BEZIER, bezier->controls);
+	}
+	return changed;
+}
+
+float ease(const EasingTable* table, float t)
+{
+	float position = (t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t)) * EASING_TABLE_SIZE;
+	int index = (int)position;
+	index = index < EASING_TABLE_SIZE ? index : EASING_TABLE_SIZE - 1;
+	float fraction = position - (float)index;
+	return table->values[index] + (table->values[index + 1] - table->values[index]) * fraction;
+}
+
+void easeColumns(const EasingTable* table, size_t count, const float* t, float* out)
+{
+	for ( size_t li = 0; li < count; ++li )
+	{
+		out[li] = ease(table, t[li]);
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+
+#define EASING_TABLE_SIZE 256
+
+enum EasingCurve
+{
+	EASING_LINEAR = 0,
+	EASING_CUBIC = 1,       // cubic ease in and out
+	EASING_EXPONENTIAL = 2, // exponential ease in and out
+	EASING_ELASTIC = 3,     // overshoots and springs back into place
+	EASING_BEZIER = 4,      // user defined cubic bezier, as in css
+	EASING_COUNT
+};
+
+// An easing curve sampled at evenly spaced progress values. Evaluating it is a table fetch and a
+// lerp whatever the curve, so the cost is the same for a bezier as for a line.
+struct EasingTable
+{
+	float values[EASING_TABLE_SIZE + 1];
+};
+
+// A user defined bezier curve and its table, owned by whatever eases with it, so curves set by
+// different sessions never touch each other. The inner control points are (x1, y1, x2, y2), the
+// curve runs from (0, 0) to (1, 1).
+struct BezierEasing
+{
+	float controls[4];
+	EasingTable table;
+};
+
+// the table for a curve; the bezier's comes from the given curve, or the css 'ease' if there is
+// none, and the others are shared and built at startup
+const EasingTable* easingTable(EasingCurve curve, const BezierEasing* bezier);
+// starts the curve as the css 'ease'
+void initBezierEasing(BezierEasing* bezier);
+// returns true if the curve changed, in which case its table is rebuilt
+bool setBezierEasing(BezierEasing* bezier, const float controls[4]);
+
+// maps linear progress in [0, 1] to eased progress, which overshoots for elastic curves
+float ease(const EasingTable* table, float t);
+void easeColumns(const EasingTable* table, size_t count, const float* t, float* out);
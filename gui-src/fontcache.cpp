@@ -0,0 +1,332 @@
+#include "fontcache.h"
+#include "mapped.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define FONT_CACHE_VERSION 1
+#define UV_LINE_COUNT (IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1)
+
+struct FontCacheHeader
+{
+	char magic[4]; // "GFNT"
+	uint32_t version;
+	uint32_t imguiVersion;
+	uint32_t glyphSize;
+	uint64_t key;
+	int32_t texWidth;
+	int32_t texHeight;
+	int32_t fontCount;
+	int32_t rectCount;
+	int32_t packIdMouseCursors;
+	int32_t packIdLines;
+	uint32_t usesColors;
+	float uvScale[2];
+	float uvWhitePixel[2];
+	float uvLines[UV_LINE_COUNT][4];
+};
+
+// followed by its glyphs, as ImFontGlyph
+struct FontCacheFont
+{
+	float fontSize;
+	float ascent;
+	float descent;
+	int32_t metricsTotalSurface;
+	uint32_t fallbackChar;
+	uint32_t ellipsisChar;
+	int32_t glyphCount;
+};
+
+// the atlas' custom rectangles, which hold the mouse cursors and baked lines
+struct FontCacheRect
+{
+	uint16_t width;
+	uint16_t height;
+	uint16_t x;
+	uint16_t y;
+	uint32_t glyphId;
+	float glyphAdvanceX;
+	float glyphOffset[2];
+	int32_t font; // index into the atlas' fonts, or -1
+};
+
+//--------------------------------------------------------------------------------------------------
+// prototypes
+//--------------------------------------------------------------------------------------------------
+
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t size);
+static uint64_t atlasKey(const ImFontAtlas* atlas);
+static int fontIndex(const ImFontAtlas* atlas, const ImFont* font);
+
+//--------------------------------------------------------------------------------------------------
+// font cache
+//--------------------------------------------------------------------------------------------------
+
+bool loadFontCache(ImFontAtlas* atlas, const char* path)
+{
+	MappedFile file;
+	if ( atlas->Fonts.Size == 0 || !mapFile(&file, path) )
+	{
+		return false;
+	}
+
+	// walk the file, checking every section fits before touching it
+	const unsigned char* cursor = (const unsigned char*)file.data;
+	const unsigned char* end = cursor + file.size;
+	auto take = [&cursor, end](size_t size) -> const unsigned char*
+	{
+		if ( (size_t)(end - cursor) < size )
+		{
+			return nullptr;
+		}
+		const unsigned char* section = cursor;
+		cursor += size;
+		return section;
+	};
+
+	FontCacheHeader header;
+	const unsigned char* section = take(sizeof(header));
+	bool valid = section != nullptr;
+	if ( valid )
+	{
+		memcpy(&header, section, sizeof(header));
+		valid = memcmp(header.magic, "GFNT", 4) == 0
+			&& header.version == FONT_CACHE_VERSION
+			&& header.imguiVersion == IMGUI_VERSION_NUM
+			&& header.glyphSize == sizeof(ImFontGlyph)
+			&& header.key == atlasKey(atlas)
+			&& header.fontCount == atlas->Fonts.Size
+			&& header.texWidth > 0 && header.texHeight > 0
+			&& header.rectCount >= 0;
+	}
+
+	// find every section before committing any of it to the atlas
+	std::vector<FontCacheFont> fonts(valid ? header.fontCount : 0);
+	std::vector<const unsigned char*> glyphs(valid ? header.fontCount : 0);
+	for ( int fi = 0; valid && fi < header.fontCount; ++fi )
+	{
+		section = take(sizeof(FontCacheFont));
+		valid = section != nullptr;
+		if ( valid )
+		{
+			memcpy(&fonts[fi], section, sizeof(FontCacheFont));
+			valid = fonts[fi].glyphCount > 0 && fonts[fi].glyphCount < 0xFFFF;
+		}
+		glyphs[fi] = valid ? take(fonts[fi].glyphCount * sizeof(ImFontGlyph)) : nullptr;
+		valid = glyphs[fi] != nullptr;
+	}
+	const unsigned char* rects = valid ? take(header.rectCount * sizeof(FontCacheRect)) : nullptr;
+	const unsigned char* pixels = rects != nullptr ? take((size_t)header.texWidth * header.texHeight) : nullptr;
+	if ( pixels == nullptr )
+	{
+		unmapFile(&file);
+		return false;
+	}
+
+	atlas->ClearTexData();
+	atlas->TexWidth = header.texWidth;
+	atlas->TexHeight = header.texHeight;
+	atlas->TexUvScale = ImVec2(header.uvScale[0], header.uvScale[1]);
+	atlas->TexUvWhitePixel = ImVec2(header.uvWhitePixel[0], header.uvWhitePixel[1]);
+	for ( int li = 0; li < UV_LINE_COUNT; ++li )
+	{
+		atlas->TexUvLines[li] = ImVec4(header.uvLines[li][0], header.uvLines[li][1], header.uvLines[li][2], header.uvLines[li][3]);
+	}
+	atlas->TexPixelsUseColors = header.usesColors != 0;
+	// the atlas frees its pixels itself, so they are copied out of the mapping
+	atlas->TexPixelsAlpha8 = (unsigned char*)IM_ALLOC((size_t)header.texWidth * header.texHeight);
+	memcpy(atlas->TexPixelsAlpha8, pixels, (size_t)header.texWidth * header.texHeight);
+
+	atlas->CustomRects.resize(header.rectCount);
+	for ( int ri = 0; ri < header.rectCount; ++ri )
+	{
+		FontCacheRect cached;
+		memcpy(&cached, rects + ri * sizeof(FontCacheRect), sizeof(cached));
+		ImFontAtlasCustomRect& rect = atlas->CustomRects[ri];
+		rect.Width = cached.width;
+		rect.Height = cached.height;
+		rect.X = cached.x;
+		rect.Y = cached.y;
+		rect.GlyphID = cached.glyphId;
+		rect.GlyphAdvanceX = cached.glyphAdvanceX;
+		rect.GlyphOffset = ImVec2(cached.glyphOffset[0], cached.glyphOffset[1]);
+		rect.Font = cached.font >= 0 && cached.font < atlas->Fonts.Size ? atlas->Fonts[cached.font] : nullptr;
+	}
+	atlas->PackIdMouseCursors = header.packIdMouseCursors;
+	atlas->PackIdLines = header.packIdLines;
+
+	for ( int fi = 0; fi < atlas->Fonts.Size; ++fi )
+	{
+		// the same setup the builder does, with the baked metrics in place of the rasterised ones
+		ImFont* font = atlas->Fonts[fi];
+		font->ContainerAtlas = atlas;
+		font->ConfigData = nullptr;
+		font->ConfigDataCount = 0;
+		for ( const ImFontConfig& config : atlas->ConfigData )
+		{
+			if ( config.DstFont == font )
+			{
+				font->ConfigData = font->ConfigData != nullptr ? font->ConfigData : &config;
+				font->ConfigDataCount++;
+			}
+		}
+		font->FontSize = fonts[fi].fontSize;
+		font->Ascent = fonts[fi].ascent;
+		font->Descent = fonts[fi].descent;
+		font->MetricsTotalSurface = fonts[fi].metricsTotalSurface;
+		font->FallbackChar = (ImWchar)fonts[fi].fallbackChar;
+		font->EllipsisChar = (ImWchar)fonts[fi].ellipsisChar;
+		font->Glyphs.resize(fonts[fi].glyphCount);
+		memcpy(font->Glyphs.Data, glyphs[fi], fonts[fi].glyphCount * sizeof(ImFontGlyph));
+		font->BuildLookupTable();
+	}
+	atlas->TexReady = true;
+
+	unmapFile(&file);
+	return true;
+}
+
+bool saveFontCache(ImFontAtlas* atlas, const char* path)
+{
+	unsigned char* pixels = nullptr;
+	int width = 0;
+	int height = 0;
+	atlas->GetTexDataAsAlpha8(&pixels, &width, &height);
+	if ( pixels == nullptr )
+	{
+		return false;
+	}
+
+	FILE* file = fopen(path, "wb");
+	if ( file == nullptr )
+	{
+		return false;
+	}
+
+	FontCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "GFNT", 4);
+	header.version = FONT_CACHE_VERSION;
+	header.imguiVersion = IMGUI_VERSION_NUM;
+	header.glyphSize = sizeof(ImFontGlyph);
+	header.key = atlasKey(atlas);
+	header.texWidth = width;
+	header.texHeight = height;
+	header.fontCount = atlas->Fonts.Size;
+	header.rectCount = atlas->CustomRects.Size;
+	header.packIdMouseCursors = atlas->PackIdMouseCursors;
+	header.packIdLines = atlas->PackIdLines;
+	header.usesColors = atlas->TexPixelsUseColors ? 1 : 0;
+	header.uvScale[0] = atlas->TexUvScale.x;
+	header.uvScale[1] = atlas->TexUvScale.y;
+	header.uvWhitePixel[0] = atlas->TexUvWhitePixel.x;
+	header.uvWhitePixel[1] = atlas->TexUvWhitePixel.y;
+	for ( int li = 0; li < UV_LINE_COUNT; ++li )
+	{
+		header.uvLines[li][0] = atlas->TexUvLines[li].x;
+		header.uvLines[li][1] = atlas->TexUvLines[li].y;
+		header.uvLines[li][2] = atlas->TexUvLines[li].z;
+		header.uvLines[li][3] = atlas->TexUvLines[li].w;
+	}
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+
+	for ( const ImFont* font : atlas->Fonts )
+	{
+		FontCacheFont cached;
+		memset(&cached, 0, sizeof(cached));
+		cached.fontSize = font->FontSize;
+		cached.ascent = font->Ascent;
+		cached.descent = font->Descent;
+		cached.metricsTotalSurface = font->MetricsTotalSurface;
+		cached.fallbackChar = font->FallbackChar;
+		cached.ellipsisChar = font->EllipsisChar;
+		cached.glyphCount = font->Glyphs.Size;
+		written = written && fwrite(&cached, sizeof(cached), 1, file) == 1;
+		written = written && fwrite(font->Glyphs.Data, sizeof(ImFontGlyph), font->Glyphs.Size, file) == (size_t)font->Glyphs.Size;
+	}
+
+	for ( const ImFontAtlasCustomRect& rect : atlas->CustomRects )
+	{
+		FontCacheRect cached;
+		memset(&cached, 0, sizeof(cached));
+		cached.width = rect.Width;
+		cached.height = rect.Height;
+		cached.x = rect.X;
+		cached.y = rect.Y;
+		cached.glyphId = rect.GlyphID;
+		cached.glyphAdvanceX = rect.GlyphAdvanceX;
+		cached.glyphOffset[0] = rect.GlyphOffset.x;
+		cached.glyphOffset[1] = rect.GlyphOffset.y;
+		cached.font = fontIndex(atlas, rect.Font);
+		written = written && fwrite(&cached, sizeof(cached), 1, file) == 1;
+	}
+
+	written = written && fwrite(pixels, (size_t)width * height, 1, file) == 1;
+	written = fclose(file) == 0 && written;
+	if ( !written )
+	{
+		// don't leave a partial cache to be rejected on every launch
+		remove(path);
+	}
+	return written;
+}
+
+// fnv-1a
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for ( size_t bi = 0; bi < size; ++bi )
+	{
+		hash = (hash ^ bytes[bi]) * 0x100000001b3ull;
+	}
+	return hash;
+}
+
+// everything the builder reads to bake the atlas
+static uint64_t atlasKey(const ImFontAtlas* atlas)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	hash = hashBytes(hash, &atlas->Flags, sizeof(atlas->Flags));
+	hash = hashBytes(hash, &atlas->TexDesiredWidth, sizeof(atlas->TexDesiredWidth));
+	hash = hashBytes(hash, &atlas->TexGlyphPadding, sizeof(atlas->TexGlyphPadding));
+	hash = hashBytes(hash, &atlas->FontBuilderFlags, sizeof(atlas->FontBuilderFlags));
+	for ( const ImFontConfig& config : atlas->ConfigData )
+	{
+		hash = hashBytes(hash, config.FontData, (size_t)config.FontDataSize);
+		hash = hashBytes(hash, &config.FontNo, sizeof(config.FontNo));
+		hash = hashBytes(hash, &config.SizePixels, sizeof(config.SizePixels));
+		hash = hashBytes(hash, &config.OversampleH, sizeof(config.OversampleH));
+		hash = hashBytes(hash, &config.OversampleV, sizeof(config.OversampleV));
+		hash = hashBytes(hash, &config.PixelSnapH, sizeof(config.PixelSnapH));
+		hash = hashBytes(hash, &config.GlyphExtraSpacing, sizeof(config.GlyphExtraSpacing));
+		hash = hashBytes(hash, &config.GlyphOffset, sizeof(config.GlyphOffset));
+		hash = hashBytes(hash, &config.GlyphMinAdvanceX, sizeof(config.GlyphMinAdvanceX));
+		hash = hashBytes(hash, &config.GlyphMaxAdvanceX, sizeof(config.GlyphMaxAdvanceX));
+		hash = hashBytes(hash, &config.MergeMode, sizeof(config.MergeMode));
+		hash = hashBytes(hash, &config.FontBuilderFlags, sizeof(config.FontBuilderFlags));
+		hash = hashBytes(hash, &config.RasterizerMultiply, sizeof(config.RasterizerMultiply));
+		hash = hashBytes(hash, &config.EllipsisChar, sizeof(config.EllipsisChar));
+		int font = fontIndex(atlas, config.DstFont);
+		hash = hashBytes(hash, &font, sizeof(font));
+		const ImWchar* ranges = config.GlyphRanges;
+		for ( ; ranges != nullptr && ranges[0] != 0; ranges += 2 )
+		{
+			hash = hashBytes(hash, ranges, 2 * sizeof(ImWchar));
+		}
+	}
+	return hash;
+}
+
+static int fontIndex(const ImFontAtlas* atlas, const ImFont* font)
+{
+	for ( int fi = 0; fi < atlas->Fonts.Size; ++fi )
+	{
+		if ( atlas->Fonts[fi] == font )
+		{
+			return fi;
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include <imgui.h>
+
+// The baked font atlas, saved so later launches skip rasterising and packing the glyphs. The file
+// records a key over every font's source data and configuration, the ImGui version and the glyph
+// layout; any mismatch, or a short or damaged file, and it is simply rebuilt.
+//
+// Both work on an atlas that has had its fonts added but not built.
+bool loadFontCache(ImFontAtlas* atlas, const char* path);
+// builds the atlas if need be, then writes it out
+bool saveFontCache(ImFontAtlas* atlas, const char* path);
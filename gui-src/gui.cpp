@@ -1,13 +1,173 @@
 #include "gui.h"
+#include "controller.h"
+#include "fontcache.h"
+#include "outliner.h"
+#include "poseviewer.h"
+#include "profiler.h"
+#include "renderer.h"
+#include "threadpool.h"
 #include <gl/freeglut.h>
 #include <imgui.h>
 #include <backends/imgui_impl_glut.h>
 #include <backends/imgui_impl_opengl2.h>
 #include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
-#define ANGLE_EPSILON 5e-2f
+#include <cstring>
+#include <memory>
 
-typedef bool (*animationFunc)(Gimbal*, float[3], float);
+// the pair main() passes to gui_update; its waypoints are filled by gui_push_waypoint or the feeder
+static Controller primaryController;
+// every pair, the primary's first and then any added with gui_add_pair, all stepped together on
+// the pool; the panel edits one of them at a time
+static std::vector<Controller*> controllers;
+static int panelPair = 0;
+static ThreadPool pool;
+static WaypointFeeder waypointFeeder;
+// set once the feeder owns the primary's queue, after which gui_push_waypoint is refused
+static std::atomic<bool> feederOwnsQueue(false);
+static SessionRecorder recorder;
+static Outliner outliner;
+// the scene handed over by gui_set_scene, animated towards its targets across the pool
+static Gimbal* sceneGimbals = nullptr;
+static size_t sceneCount = 0;
+static AnimationBatch sceneBatch;
+static size_t sceneRunning = 0; // transitions still running after the last frame
+static AnimationClock sceneClock; // steps the scene at the panel's step rate, whatever the frame rate
+static float sceneBezier[4];      // the bezier curve the scene's running transitions were started with
+// while the primary plays its timeline the scene plays it too, sampled for every gimbal in one pass
+static bool sceneFollowing = false;
+static std::vector<double> sceneTimes;
+static std::vector<float> sceneX, sceneY, sceneZ;
+// a queue per scene gimbal, made when the feeder starts with a scene set and filled only by it
+static std::unique_ptr<WaypointQueue[]> sceneWaypoints;
+static size_t sceneWaypointCount = 0;
+static PoseViewer poseViewer;
+
+// the baked font atlas, beside imgui.ini
+#define FONT_CACHE_PATH "imgui_fonts.cache"
+
+// After the last input event frames keep being built for this long, so hover highlights settle
+// and delayed tooltips get to open. Past it, with nothing animating, the last frame is reused.
+#define IDLE_GRACE_MS 1000
+// the delta time of the first frame after an idle stretch, which otherwise spans the whole stretch
+#define IDLE_RESUME_DELTA (1.0f / 60.0f)
+
+static int lastInputMs = 0;
+static bool frameSkipped = false;
+static bool viewportClicked = false;
+static int clickX = 0;
+static int clickY = 0;
+static enum Axis selectedAxis = AXIS_NONE;
+
+// the left button held down after a press on the 3D view, as the GLUT events left it
+struct ViewportDrag
+{
+	bool held;
+	int x;
+	int y;
+};
+
+static ViewportDrag viewportDrag = {};
+
+// where the profiler's input to screen latency is dumped from its panel
+#define PROFILE_DUMP_PATH "profile.csv"
+
+// what the profiler panel keeps between frames
+struct ProfilerPanel
+{
+	ProfileStats stats;     // as last worked out
+	double statsTime;       // gui time they were worked out at, negative before the first time
+	const char* dumpStatus; // how the last dump went, empty before the first
+};
+
+static ProfilerPanel profilerPanel = { {}, -1.0, "" };
+
+//--------------------------------------------------------------------------------------------------
+// input callbacks, forwarded to the backend after noting the time
+//--------------------------------------------------------------------------------------------------
+
+static void wakeGui()
+{
+	profiler_input();
+	lastInputMs = glutGet(GLUT_ELAPSED_TIME);
+	glutPostRedisplay();
+}
+
+static void reshapeInput(int w, int h)
+{
+	ImGui_ImplGLUT_ReshapeFunc(w, h);
+	wakeGui();
+}
+
+static void motionInput(int x, int y)
+{
+	ImGui_ImplGLUT_MotionFunc(x, y);
+	if (viewportDrag.held)
+	{
+		viewportDrag.x = x;
+		viewportDrag.y = y;
+	}
+	wakeGui();
+}
+
+static void mouseInput(int button, int state, int x, int y)
+{
+	ImGui_ImplGLUT_MouseFunc(button, state, x, y);
+	// whether the gui wants the mouse is known from the last frame, which is what the user saw
+	if (button == GLUT_LEFT_BUTTON && state == GLUT_DOWN && !ImGui::GetIO().WantCaptureMouse)
+	{
+		viewportClicked = true;
+		clickX = x;
+		clickY = y;
+		viewportDrag.held = true;
+		viewportDrag.x = x;
+		viewportDrag.y = y;
+	}
+	else if (button == GLUT_LEFT_BUTTON && state == GLUT_UP)
+	{
+		viewportDrag.held = false;
+	}
+	wakeGui();
+}
+
+#ifdef __FREEGLUT_EXT_H__
+static void mouseWheelInput(int button, int dir, int x, int y)
+{
+	ImGui_ImplGLUT_MouseWheelFunc(button, dir, x, y);
+	wakeGui();
+}
+#endif
+
+static void keyboardInput(unsigned char c, int x, int y)
+{
+	ImGui_ImplGLUT_KeyboardFunc(c, x, y);
+	wakeGui();
+}
+
+static void keyboardUpInput(unsigned char c, int x, int y)
+{
+	ImGui_ImplGLUT_KeyboardUpFunc(c, x, y);
+	wakeGui();
+}
+
+static void specialInput(int key, int x, int y)
+{
+	ImGui_ImplGLUT_SpecialFunc(key, x, y);
+	wakeGui();
+}
+
+static void specialUpInput(int key, int x, int y)
+{
+	ImGui_ImplGLUT_SpecialUpFunc(key, x, y);
+	wakeGui();
+}
+
+//--------------------------------------------------------------------------------------------------
+// panel
+//--------------------------------------------------------------------------------------------------
 
 void helpMarker( const char* desc )
 {
@@ -62,204 +222,12 @@ bool rotateAxis(Gimbal* gimbal, Axis axis, char* label, float speed)
 	return active;
 }
 
-bool animateSequentially(Gimbal* gimbal, float target[3], float rotationDegPerSecond)
-{
-	for ( int ti = 0; ti < 3; ++ti )
-	{
-		if ( target[ti] >= 180.0f )
-		{
-			target[ti] -= 360.0f;
-		}
-		else if ( target[ti] < -180.0f )
-		{
-			target[ti] += 360.0f;
-		}
-	}
-	// calculate the difference between the current rotation and the target
-	float diff[3] = { target[AXIS_X] - gimbal->rotation[AXIS_X], target[AXIS_Y] - gimbal->rotation[AXIS_Y], target[AXIS_Z] - gimbal->rotation[AXIS_Z] };
-	float dir[] = {
-		diff[AXIS_X] >= 180.0f ? -1.0f : (diff[AXIS_X] < 0.0f ? -1.0f : 1.0f),
-		diff[AXIS_Y] >= 180.0f ? -1.0f : (diff[AXIS_Y] < 0.0f ? -1.0f : 1.0f),
-		diff[AXIS_Z] >= 180.0f ? -1.0f : (diff[AXIS_Z] < 0.0f ? -1.0f : 1.0f)
-	};
-
-	bool done[] = {
-		(diff[AXIS_X] <= ANGLE_EPSILON && diff[AXIS_X] >= -ANGLE_EPSILON),
-		(diff[AXIS_Y] <= ANGLE_EPSILON && diff[AXIS_Y] >= -ANGLE_EPSILON),
-		(diff[AXIS_Z] <= ANGLE_EPSILON && diff[AXIS_Z] >= -ANGLE_EPSILON)
-	};
-
-	int first, second, third;
-	switch ( gimbal->eulerMode )
-	{
-	case EULER_MODE_XYZ:
-		first = AXIS_Z;
-		second = AXIS_Y;
-		third = AXIS_X;
-		break;
-	case EULER_MODE_XZY:
-		first = AXIS_Y;
-		second = AXIS_Z;
-		third = AXIS_X;
-		break;
-	case EULER_MODE_YXZ:
-		first = AXIS_Z;
-		second = AXIS_X;
-		third = AXIS_Y;
-		break;
-	case EULER_MODE_YZX:
-		first = AXIS_X;
-		second = AXIS_Z;
-		third = AXIS_Y;
-		break;
-	case EULER_MODE_ZXY:
-		first = AXIS_Y;
-		second = AXIS_X;
-		third = AXIS_Z;
-		break;
-	case EULER_MODE_ZYX:
-		first = AXIS_X;
-		second = AXIS_Y;
-		third = AXIS_Z;
-		break;
-	}
-
-	// move each axis one after the other
-	if ( !done[first] )
-	{
-		gimbal->rotation[first] += dir[first] * rotationDegPerSecond * ImGui::GetIO().DeltaTime;
-		if ( gimbal->rotation[first] >= 180.0f )
-		{
-			gimbal->rotation[first] -= 360.0f;
-		}
-		else if ( gimbal->rotation[first] < -180.0f )
-		{
-			gimbal->rotation[first] += 360.0f;
-		}
-	}
-	else if ( !done[second] )
-	{
-		gimbal->rotation[first] = target[first];
-		gimbal->rotation[second] += dir[second] * rotationDegPerSecond * ImGui::GetIO().DeltaTime;
-		if ( gimbal->rotation[second] >= 180.0f )
-		{
-			gimbal->rotation[second] -= 360.0f;
-		}
-		else if ( gimbal->rotation[second] < -180.0f )
-		{
-			gimbal->rotation[second] += 360.0f;
-		}
-	}
-	else if ( !done[third] )
-	{
-		gimbal->rotation[second] = target[second];
-		gimbal->rotation[third] += dir[third] * rotationDegPerSecond * ImGui::GetIO().DeltaTime;
-		if ( gimbal->rotation[third] >= 180.0f )
-		{
-			gimbal->rotation[third] -= 360.0f;
-		}
-		else if ( gimbal->rotation[third] < -180.0f )
-		{
-			gimbal->rotation[third] += 360.0f;
-		}
-	}
-	else // done
-	{
-		gimbal->rotation[first] = target[first];
-		gimbal->rotation[second] = target[second];
-		gimbal->rotation[third] = target[third];
-		return true;
-	}
-
-	return false;
-}
-
-bool animateConcurrently(Gimbal* gimbal, float target[3], float rotationDegPerSecond)
-{
-	for ( int ti = 0; ti < 3; ++ti )
-	{
-		if ( target[ti] >= 180.0f )
-		{
-			target[ti] -= 360.0f;
-		}
-		else if ( target[ti] < -180.0f )
-		{
-			target[ti] += 360.0f;
-		}
-	}
-	// calculate the difference between the current rotation and the target
-	float diff[3] = { target[AXIS_X] - gimbal->rotation[AXIS_X], target[AXIS_Y] - gimbal->rotation[AXIS_Y], target[AXIS_Z] - gimbal->rotation[AXIS_Z] };
-	float dir[] = {
-		diff[AXIS_X] >= 180.0f ? -1.0f : (diff[AXIS_X] < 0.0f ? -1.0f : 1.0f),
-		diff[AXIS_Y] >= 180.0f ? -1.0f : (diff[AXIS_Y] < 0.0f ? -1.0f : 1.0f),
-		diff[AXIS_Z] >= 180.0f ? -1.0f : (diff[AXIS_Z] < 0.0f ? -1.0f : 1.0f)
-	};
-
-	// find the largest delta
-	float largestDelta = fabs(diff[0]);
-	for ( int di = 1; di < 3; ++di )
-	{
-		float delta = fabs(diff[di]);
-		if ( delta > largestDelta )
-		{
-			largestDelta = delta;
-		}
-	}
-
-	bool finished = sqrtf(diff[0] * diff[0] + diff[1] * diff[1] + diff[2] * diff[2]) <= ANGLE_EPSILON;
-	if ( finished )
-	{
-		// fix the rotation to the target and return
-		gimbal->rotation[0] = target[0];
-		gimbal->rotation[1] = target[1];
-		gimbal->rotation[2] = target[2];
-		return true;
-	}
-	else
-	{
-		float modifiers[] = {
-			fabsf(diff[0]) / largestDelta,
-			fabsf(diff[1]) / largestDelta,
-			fabsf(diff[2]) / largestDelta
-		};
-
-		// move the axes concurrently
-		gimbal->rotation[0] += dir[0] * rotationDegPerSecond * ImGui::GetIO().DeltaTime * modifiers[0];
-		if ( gimbal->rotation[0] >= 180.0f )
-		{
-			gimbal->rotation[0] -= 360.0f;
-		}
-		else if ( gimbal->rotation[0] < -180.0f )
-		{
-			gimbal->rotation[0] += 360.0f;
-		}
-
-		gimbal->rotation[1] += dir[1] * rotationDegPerSecond * ImGui::GetIO().DeltaTime * modifiers[1];
-		if ( gimbal->rotation[1] >= 180.0f )
-		{
-			gimbal->rotation[1] -= 360.0f;
-		}
-		else if ( gimbal->rotation[1] < -180.0f )
-		{
-			gimbal->rotation[1] += 360.0f;
-		}
-
-		gimbal->rotation[2] += dir[2] * rotationDegPerSecond * ImGui::GetIO().DeltaTime * modifiers[2];
-		if ( gimbal->rotation[2] >= 180.0f )
-		{
-			gimbal->rotation[2] -= 360.0f;
-		}
-		else if ( gimbal->rotation[2] < -180.0f )
-		{
-			gimbal->rotation[2] += 360.0f;
-		}
-	}
-
-	return false;
-}
-
 void gui_init()
 {
+	initController(&primaryController, nullptr, nullptr);
+	controllers.assign(1, &primaryController);
+	startThreadPool(&pool, 0);
+
 	IMGUI_CHECKVERSION();
 	ImGui::CreateContext();
 	ImGui::StyleColorsDark();
@@ -268,6 +236,13 @@ void gui_init()
 	ImGuiIO &io = ImGui::GetIO(); (void)io;
 	io.DisplaySize = ImVec2(1200, 1200);
 
+	// rasterising the fonts is most of the startup cost, so the baked atlas is kept between runs
+	io.Fonts->AddFontDefault();
+	if (!loadFontCache(io.Fonts, FONT_CACHE_PATH))
+	{
+		saveFontCache(io.Fonts, FONT_CACHE_PATH);
+	}
+
 	ImGuiStyle& style = ImGui::GetStyle();
 	style.WindowRounding = 4.0f;
 	style.FrameRounding = 4.0f;
@@ -278,20 +253,42 @@ void gui_init()
 	ImGui_ImplGLUT_Init();
 	ImGui_ImplOpenGL2_Init();
 
-	// install the callback funcs
-	ImGui_ImplGLUT_InstallFuncs();
+	// install the callback funcs, wrapped so input wakes an idle gui
+	glutReshapeFunc(reshapeInput);
+	glutMotionFunc(motionInput);
+	glutPassiveMotionFunc(motionInput);
+	glutMouseFunc(mouseInput);
+#ifdef __FREEGLUT_EXT_H__
+	glutMouseWheelFunc(mouseWheelInput);
+#endif
+	glutKeyboardFunc(keyboardInput);
+	glutKeyboardUpFunc(keyboardUpInput);
+	glutSpecialFunc(specialInput);
+	glutSpecialUpFunc(specialUpInput);
+	lastInputMs = glutGet(GLUT_ELAPSED_TIME);
 }
 
-void gui_update(Gimbal* gimbal, Gimbal* target)
+// builds the panel, editing the gimbals in place and collecting everything else into the input
+void buildPanel(Controller* controller)
 {
-	ImGui_ImplOpenGL2_NewFrame();
-	ImGui_ImplGLUT_NewFrame();
-	ImGui::NewFrame();
+	const Session* session = &controller->session;
+	SessionInput* input = &controller->input;
+	Gimbal* gimbal = controller->gimbal;
+	Gimbal* target = controller->target;
+
+	*input = session->settings;
+	input->deltaTime = ImGui::GetIO().DeltaTime;
 
-	ImGui::SetNextWindowSize(ImVec2(280, 420));
+	bool pairs = controllers.size() > 1;
+	ImGui::SetNextWindowSize(ImVec2(280, pairs ? 630.0f : 605.0f));
 	ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_FirstUseEver);
 	ImGui::Begin("Euler Rotation Demo", nullptr, ImGuiWindowFlags_NoResize);
-		static int selector = 0;
+		// which pair the panel edits, the others carry on with the settings they were left with
+		if (pairs)
+		{
+			ImGui::SetNextItemWidth(-FLT_MIN);
+			ImGui::SliderInt("##pair", &panelPair, 0, (int) controllers.size() - 1, "Pair %d", ImGuiSliderFlags_AlwaysClamp);
+		}
 		ImGui::SeparatorText("Display Options");
 		ImGui::Text("Primary:");
 		ImGui::SameLine();
@@ -342,7 +339,7 @@ so the order of the rotations can change the final outcome.";
 		// bit of a hack to get the target to update the euler mode
 		target->eulerMode = gimbal->eulerMode;
 
-		static float rotationDegPerSecond = 6.0f;
+		float rotationDegPerSecond = input->rotationDegPerSecond;
 		enum Axis activeAxis = AXIS_NONE;
 		ImGui::SeparatorText("Rotations");
 			if (ImGui::IsItemHovered())
@@ -380,7 +377,7 @@ the direction of rotation based on a right-hand coordinate system.";
 		{
 			activeAxis = AXIS_Z;
 		}
-		gimbal->activeAxis = activeAxis;
+		gimbal->activeAxis = activeAxis != AXIS_NONE ? activeAxis : selectedAxis;
 		activeAxis = AXIS_NONE;
 		ImGui::SameLine(0.0f, 3.0f);
 		ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.8f, 0.2f, 0.2f, 1.0f));
@@ -439,19 +436,18 @@ the direction of rotation based on a right-hand coordinate system.";
 		}
 		ImGui::PopStyleColor();
 
-		static bool animate = false;
 		ImGui::Spacing();
 		ImGui::SeparatorText("Animation Options");
 		ImGui::PushItemWidth(120.0f);
-		if (ImGui::DragFloat("Rotation Speed##rotSpeed", &rotationDegPerSecond, 0.1f, 0.0f, 30.0f, "%.1f (deg/s)"))
+		if (ImGui::DragFloat("Rotation Speed##rotSpeed", &input->rotationDegPerSecond, 0.1f, 0.0f, 30.0f, "%.1f (deg/s)"))
 		{
-			if (rotationDegPerSecond <= 0.0f)
+			if (input->rotationDegPerSecond <= 0.0f)
 			{
-				rotationDegPerSecond = 0.0f;
+				input->rotationDegPerSecond = 0.0f;
 			}
-			else if (rotationDegPerSecond >= 30.0f)
+			else if (input->rotationDegPerSecond >= 30.0f)
 			{
-				rotationDegPerSecond = 30.0f;
+				input->rotationDegPerSecond = 30.0f;
 			}
 		}
 		ImGui::PopItemWidth();
@@ -467,12 +463,106 @@ the direction of rotation based on a right-hand coordinate system.";
 			}
 		}
 
+		const AnimationClock& clock = session->clock;
+		ImGui::PushItemWidth(120.0f);
+		ImGui::DragInt("Step Rate##stepRate", &input->stepRate, 1.0f, MIN_STEP_RATE, MAX_STEP_RATE, "%d (Hz)", ImGuiSliderFlags_AlwaysClamp);
+		ImGui::PopItemWidth();
+		if (ImGui::IsItemHovered())
+		{
+			if (ImGui::BeginTooltip())
+			{
+				const char* desc = "Fixed rate the animation is simulated at, independent of the frame rate [10 , 1000]";
+				ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+				ImGui::Text(desc);
+				ImGui::PopTextWrapPos();
+				ImGui::EndTooltip();
+			}
+		}
+
 		ImGui::Spacing();
-		static const animationFunc animations[] = { animateSequentially, animateConcurrently };
-		static int animationMode = 0;
-		ImGui::RadioButton("Sequential", &animationMode, 0);
+		ImGui::RadioButton("Sequential", &input->animationMode, ANIMATION_SEQUENTIAL);
+		ImGui::SameLine(0.0f, 10.0f);
+		ImGui::RadioButton("Concurrent", &input->animationMode, ANIMATION_CONCURRENT);
 		ImGui::SameLine(0.0f, 10.0f);
-		ImGui::RadioButton("Concurrent", &animationMode, 1);
+		ImGui::SetNextItemWidth(-FLT_MIN);
+		ImGui::Combo("##easing", &input->easing, "Linear\0Cubic\0Exponential\0Elastic\0Bezier\0");
+		if (ImGui::IsItemHovered())
+		{
+			if (ImGui::BeginTooltip())
+			{
+				const char* desc = "Easing curve the rotation speeds up and slows down with, the animation takes the same time whichever is chosen";
+				ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+				ImGui::Text(desc);
+				ImGui::PopTextWrapPos();
+				ImGui::EndTooltip();
+			}
+		}
+
+		// inner control points of the bezier curve, x1 y1 x2 y2
+		ImGui::BeginDisabled(input->easing != EASING_BEZIER);
+		ImGui::SetNextItemWidth(-FLT_MIN);
+		ImGui::DragFloat4("##bezier", input->bezier, 0.01f, -1.0f, 2.0f, "%.2f");
+		ImGui::EndDisabled();
+
+		// replay repeated transitions from baked pose buffers
+		const BakeCache& bakeCache = session->bakeCache;
+		ImGui::Checkbox("Bake##bake", &input->bake);
+		if (ImGui::IsItemHovered())
+		{
+			if (ImGui::BeginTooltip())
+			{
+				const char* desc = " \
+Samples each transition once into a buffer and plays it back from there; \
+the least recently used transitions are dropped when the cache is full.";
+				ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+				ImGui::Text(desc);
+				ImGui::PopTextWrapPos();
+				ImGui::EndTooltip();
+			}
+		}
+		ImGui::SameLine(0.0f, 10.0f);
+		ImGui::TextDisabled("%zu cached, %.1f / %.1f MB", bakeCache.entries.size(),
+			bakeCache.used / (1024.0f * 1024.0f), bakeCache.budget / (1024.0f * 1024.0f));
+
+		// keyframed poses played instead of the primary -> target transition
+		const Timeline& timeline = session->timeline;
+		ImGui::Spacing();
+		ImGui::SeparatorText("Timeline");
+		if (ImGui::IsItemHovered())
+		{
+			if (ImGui::BeginTooltip())
+			{
+				const char* desc = " \
+'Add Key' appends the primary rotation to the timeline, spaced from the previous key by the \
+time it takes to rotate there concurrently at the chosen speed.\n \
+With 'Play' ticked the Play/Stop controls play the timeline instead of the target rotation.\n \
+Linear moves straight between keys, Catmull-Rom and SQUAD curve through them so the speed \
+doesn't jump at each key. Catmull-Rom curves the euler angles, SQUAD the orientations.";
+				ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+				ImGui::Text(desc);
+				ImGui::PopTextWrapPos();
+			}
+			ImGui::EndTooltip();
+		}
+
+		if (ImGui::Button("Add Key"))
+		{
+			input->actions |= ACTION_ADD_KEY;
+		}
+		ImGui::SameLine(0.0f, 3.0f);
+		ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.8f, 0.2f, 0.2f, 1.0f));
+		if (ImGui::Button("Clear##clear_timeline"))
+		{
+			input->actions |= ACTION_CLEAR_KEYS;
+		}
+		ImGui::PopStyleColor();
+		ImGui::SameLine(0.0f, 10.0f);
+		ImGui::Checkbox("Play##play_timeline", &input->playTimeline);
+		ImGui::SameLine(0.0f, 10.0f);
+		ImGui::TextDisabled("%d keys", (int) keyCount(&timeline));
+		ImGui::SetNextItemWidth(-FLT_MIN);
+		ImGui::Combo("##interpolation", &input->interpolation, "Linear\0Catmull-Rom\0SQUAD\0");
+		bool timelineActive = isTimelineActive(session);
 
 		ImGui::Spacing();
 		ImGui::SeparatorText("Animation Controls");
@@ -486,35 +576,485 @@ the direction of rotation based on a right-hand coordinate system.";
 		ImGui::SetCursorPosX(centerSpacing - (centerPadding / 2.0f));
 		if (ImGui::Button("Play"))
 		{
-			animate = true;
+			input->actions |= ACTION_PLAY;
 		}
 		ImGui::SameLine();
 
 		ImGui::SetCursorPosX(centerSpacing + buttonWidth + (centerPadding * 2.0f));
 		if (ImGui::Button("Stop"))
 		{
-			animate = false;
+			input->actions |= ACTION_STOP;
 		}
 		ImGui::PopStyleVar();
+		ImGui::SameLine(0.0f, 10.0f);
+		ImGui::TextDisabled("%zu queued", pendingWaypoints(&controller->waypoints));
 
-		if ( animate )
+		// scrub bar over the timeline or current transition, editing the gimbals starts a new
+		// transition on play
+		bool scrubbable = timelineActive || isClockCurrent(&clock, gimbal, target->rotation, input->rotationDegPerSecond, (AnimationMode) input->animationMode);
+		double duration = timelineActive ? timelineDuration(&timeline) : (scrubbable ? transitionDuration(&clock.transition) : 0.0);
+		scrubbable = scrubbable && std::isfinite(duration);
+		float scrubTime = scrubbable ? (float) clockTime(&clock) : 0.0f;
+		ImGui::BeginDisabled(!scrubbable);
+		ImGui::SetNextItemWidth(-FLT_MIN);
+		if (ImGui::SliderFloat("##scrub", &scrubTime, 0.0f, scrubbable ? (float) duration : 0.0f, "%.2f s"))
 		{
-			if ( animations[animationMode](gimbal, target->rotation, rotationDegPerSecond) )
+			input->actions |= ACTION_SEEK;
+			input->seekTime = scrubTime;
+		}
+		ImGui::EndDisabled();
+	ImGui::End();
+}
+
+// whether a scene gimbal has waypoints it hasn't started towards yet
+static bool sceneWaypointsWaiting()
+{
+	for (size_t gi : sceneBatch.queued)
+	{
+		if (pendingWaypoints(sceneBatch.waypoints[gi]) > 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool gui_wants_update()
+{
+	// an item being dragged or typed into can change without new input, e.g. a blinking cursor
+	bool pairMoving = false;
+	for (const Controller* controller : controllers)
+	{
+		bool waypointWaiting = (controller->session.hasWaypoint || pendingWaypoints(&controller->waypoints) > 0)
+			&& !isTimelineActive(&controller->session);
+		pairMoving = pairMoving || controller->session.animate || waypointWaiting;
+	}
+	return pairMoving
+		|| sceneRunning > 0
+		|| sceneWaypointsWaiting()
+		|| poseViewer.playing
+		|| glutGet(GLUT_ELAPSED_TIME) - lastInputMs < IDLE_GRACE_MS
+		|| ImGui::IsAnyItemActive()
+		|| ImGui::GetIO().WantTextInput;
+}
+
+// frame time percentiles, in a window of its own that starts collapsed
+void buildProfilerPanel()
+{
+	ImGui::SetNextWindowPos(ImVec2(10, 625), ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowSize(ImVec2(280, 0), ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowCollapsed(true, ImGuiCond_FirstUseEver);
+	if (ImGui::Begin("Profiler", nullptr, ImGuiWindowFlags_NoResize))
+	{
+		// the stats are only worked out while someone is looking at them, and a few times a second
+		// at most, which keeps the profiler well under 1% of the frame even with the panel open
+		if (ImGui::GetTime() - profilerPanel.statsTime >= 0.25 || profilerPanel.statsTime < 0.0)
+		{
+			profiler_stats(&profilerPanel.stats);
+			profilerPanel.statsTime = ImGui::GetTime();
+		}
+		const ProfileStats& stats = profilerPanel.stats;
+
+		static const char* phaseNames[PROFILE_PHASE_COUNT] = { "Frame", "GUI Update", "Gimbals", "GUI Render" };
+		if (ImGui::BeginTable("##profile", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp))
+		{
+			ImGui::TableSetupColumn("ms", ImGuiTableColumnFlags_WidthStretch, 2.0f);
+			ImGui::TableSetupColumn("p50");
+			ImGui::TableSetupColumn("p95");
+			ImGui::TableSetupColumn("p99");
+			ImGui::TableSetupColumn("max");
+			ImGui::TableHeadersRow();
+			for (int pi = 0; pi < PROFILE_PHASE_COUNT; ++pi)
 			{
-				animate = false;
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn(); ImGui::TextUnformatted(phaseNames[pi]);
+				ImGui::TableNextColumn(); ImGui::Text("%.2f", stats.p50[pi]);
+				ImGui::TableNextColumn(); ImGui::Text("%.2f", stats.p95[pi]);
+				ImGui::TableNextColumn(); ImGui::Text("%.2f", stats.p99[pi]);
+				ImGui::TableNextColumn(); ImGui::Text("%.2f", stats.worst[pi]);
+			}
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::TextUnformatted("Input");
+			if (ImGui::IsItemHovered())
+			{
+				if (ImGui::BeginTooltip())
+				{
+					ImGui::Text("From an input event arriving to the flush of the frame showing it, over %u frames with input", stats.inputFrames);
+					ImGui::EndTooltip();
+				}
+			}
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", stats.inputP50);
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", stats.inputP95);
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", stats.inputP99);
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", stats.inputWorst);
+			ImGui::EndTable();
+		}
+
+		ImGui::Text("Worst frame %u frames ago: %.2f ms", stats.worstAge, stats.worstFrame[PROFILE_FRAME]);
+		if (ImGui::IsItemHovered())
+		{
+			if (ImGui::BeginTooltip())
+			{
+				ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+				for (int pi = 1; pi < PROFILE_PHASE_COUNT; ++pi)
+				{
+					ImGui::Text("%s: %.2f ms", phaseNames[pi], stats.worstFrame[pi]);
+				}
+				ImGui::PopTextWrapPos();
+				ImGui::EndTooltip();
 			}
 		}
+
+		char overlay[48];
+		snprintf(overlay, sizeof(overlay), "%u frames, 0 - %.1f ms", stats.frames, stats.worst[PROFILE_FRAME]);
+		ImGui::PlotHistogram("##histogram", stats.histogram, PROFILE_HISTOGRAM_BUCKETS, 0, overlay, 0.0f, FLT_MAX, ImVec2(-FLT_MIN, 60.0f));
+
+		if (ImGui::Button("Dump CSV"))
+		{
+			profilerPanel.dumpStatus = profiler_dump(PROFILE_DUMP_PATH) ? "written to " PROFILE_DUMP_PATH : "could not write " PROFILE_DUMP_PATH;
+		}
+		ImGui::SameLine();
+		ImGui::TextDisabled("%s", profilerPanel.dumpStatus);
+	}
 	ImGui::End();
 }
 
+void gui_update(Gimbal* gimbal, Gimbal* target)
+{
+	if (!gui_wants_update() && ImGui::GetDrawData() != nullptr)
+	{
+		// nothing can have changed since the last frame, so gui_render draws it again
+		frameSkipped = true;
+		return;
+	}
+
+	ImGui_ImplOpenGL2_NewFrame();
+	ImGui_ImplGLUT_NewFrame();
+	if (frameSkipped)
+	{
+		ImGuiIO& io = ImGui::GetIO();
+		io.DeltaTime = std::min(io.DeltaTime, IDLE_RESUME_DELTA);
+		frameSkipped = false;
+	}
+	ImGui::NewFrame();
+
+	Controller* controller = &primaryController;
+	controller->gimbal = gimbal;
+	controller->target = target;
+	Controller* edited = controllers[panelPair < (int) controllers.size() ? panelPair : 0];
+	for (Controller* pair : controllers)
+	{
+		if (pair != edited)
+		{
+			pair->input = pair->session.settings;
+			pair->input.deltaTime = ImGui::GetIO().DeltaTime;
+		}
+	}
+	buildPanel(edited);
+	buildProfilerPanel();
+	buildOutliner(&outliner);
+	buildPoseViewer(&poseViewer, gimbal, ImGui::GetIO().DeltaTime);
+
+	Gimbal gimbalBefore = *gimbal;
+	Gimbal targetBefore = *target;
+	updateControllers(controllers.data(), controllers.size(), &pool);
+	recordFrame(&recorder, &controller->input, &gimbalBefore, &targetBefore, gimbal->rotation);
+
+	// a gimbal edited in the outliner heads for its target again from where it was left, and only
+	// the entries running or edited are visited or stored
+	for (uint32_t index : outliner.edited)
+	{
+		if (index < sceneCount)
+		{
+			restartBatch(&sceneBatch, index, sceneGimbals[index].rotation);
+		}
+	}
+
+	// While the primary plays its timeline the scene plays the same keys, each gimbal a little faster
+	// than the one before so the crowd fans out along the path, from 1x for the first to 2x for the
+	// last. The times rise with the index, which keeps the sampler on its O(1) forward path. The
+	// angles are applied as they are, in each gimbal's own mode. When the timeline stops, every
+	// gimbal heads for its target again from where it was left.
+	bool following = sceneCount > 0 && isTimelineActive(&controller->session);
+	if (following)
+	{
+		Timeline* timeline = &controller->session.timeline;
+		double time = clockTime(&controller->session.clock);
+		double duration = timelineDuration(timeline);
+		sceneTimes.resize(sceneCount);
+		sceneX.resize(sceneCount);
+		sceneY.resize(sceneCount);
+		sceneZ.resize(sceneCount);
+		for (size_t gi = 0; gi < sceneCount; ++gi)
+		{
+			sceneTimes[gi] = std::min(time * (1.0 + (double) gi / (double) sceneCount), duration);
+		}
+		sampleTimelineBatch(timeline, sceneTimes.data(), sceneCount, sceneX.data(), sceneY.data(), sceneZ.data());
+		for (size_t gi = 0; gi < sceneCount; ++gi)
+		{
+			sceneGimbals[gi].rotation[AXIS_X] = sceneX[gi];
+			sceneGimbals[gi].rotation[AXIS_Y] = sceneY[gi];
+			sceneGimbals[gi].rotation[AXIS_Z] = sceneZ[gi];
+		}
+	}
+	else if (sceneFollowing)
+	{
+		for (size_t gi = 0; gi < sceneCount; ++gi)
+		{
+			restartBatch(&sceneBatch, gi, sceneGimbals[gi].rotation);
+		}
+		sceneRunning = countBits(&sceneBatch.active);
+	}
+	sceneFollowing = following;
+	if (following)
+	{
+		return;
+	}
+
+	// the scene follows the primary's speed, mode and easing, its running transitions starting again
+	// from where they are when one of them changes
+	const SessionInput* settings = &controller->session.settings;
+	if (settings->rotationDegPerSecond != sceneBatch.rotationDegPerSecond || settings->animationMode != (int) sceneBatch.mode
+		|| settings->easing != (int) sceneBatch.easing || memcmp(settings->bezier, sceneBezier, sizeof(sceneBezier)) != 0)
+	{
+		setBatchSettings(&sceneBatch, settings->rotationDegPerSecond, (AnimationMode) settings->animationMode, (EasingCurve) settings->easing);
+		memcpy(sceneBezier, settings->bezier, sizeof(sceneBezier));
+		sceneRunning = countBits(&sceneBatch.active);
+	}
+
+	// the scene moves on whether or not the panel's pair is animating, in the same fixed steps as the
+	// primary so its poses don't depend on the frame rate
+	if (sceneRunning > 0 || !outliner.edited.empty() || sceneWaypointsWaiting())
+	{
+		sceneClock.stepRate = settings->stepRate;
+		long long stepBefore = sceneClock.step;
+		tickClock(&sceneClock, ImGui::GetIO().DeltaTime);
+		float stepTime = (float) ((double) (sceneClock.step - stepBefore) * stepDuration(&sceneClock));
+		sceneRunning = animateBatch(&sceneBatch, stepTime, &pool);
+		storeBatch(&sceneBatch, sceneGimbals, sceneCount);
+	}
+	else
+	{
+		resetClock(&sceneClock);
+	}
+}
+
+void gui_set_scene(Gimbal* gimbals, const Gimbal* targets, size_t count)
+{
+	setOutlinerScene(&outliner, gimbals, count);
+
+	// the gimbals start towards their targets at the speed, mode and easing the panel has now
+	const SessionInput* settings = &primaryController.session.settings;
+	sceneGimbals = gimbals;
+	sceneCount = targets != nullptr ? count : 0;
+	loadBatch(&sceneBatch, gimbals, targets, sceneCount, settings->rotationDegPerSecond, (AnimationMode)settings->animationMode, (EasingCurve)settings->easing, &primaryController.session.bezier);
+	memcpy(sceneBezier, settings->bezier, sizeof(sceneBezier));
+	// the feeder's queues stay where they are for as long as it runs, so they carry over to a new
+	// scene for the gimbals it shares with the old one
+	for (size_t gi = 0; gi < std::min(sceneCount, sceneWaypointCount); ++gi)
+	{
+		attachWaypoints(&sceneBatch, gi, &sceneWaypoints[gi]);
+	}
+	sceneRunning = countBits(&sceneBatch.active);
+	sceneFollowing = false;
+	resetClock(&sceneClock);
+}
+
+void gui_select_gimbal(size_t index)
+{
+	selectOutlinerGimbal(&outliner, index);
+}
+
+void gui_add_pair(Gimbal* gimbal, Gimbal* target)
+{
+	Controller* pair = new Controller();
+	initController(pair, gimbal, target);
+	controllers.push_back(pair);
+}
+
+bool gui_open_poses(const char* path)
+{
+	return openPoseViewer(&poseViewer, path);
+}
+
+bool gui_push_waypoint(const float rotation[3])
+{
+	// the queue takes one producer, and once the feeder has it that is the feeder
+	if (feederOwnsQueue.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+	return pushWaypoint(&primaryController.waypoints, rotation);
+}
+
+bool gui_feed_waypoints(const char* path)
+{
+	// one feeder at a time
+	if (waypointFeeder.file != nullptr)
+	{
+		return false;
+	}
+
+	// the scene's gimbals get queues of their own, fed by the same thread
+	if (sceneCount > 0 && sceneWaypoints == nullptr)
+	{
+		sceneWaypoints.reset(new WaypointQueue[sceneCount]());
+		sceneWaypointCount = sceneCount;
+		for (size_t gi = 0; gi < sceneCount; ++gi)
+		{
+			attachWaypoints(&sceneBatch, gi, &sceneWaypoints[gi]);
+		}
+	}
+
+	feederOwnsQueue.store(true, std::memory_order_release);
+	if (!startWaypointFeeder(&waypointFeeder, &primaryController.waypoints, sceneWaypoints.get(), sceneWaypointCount, path))
+	{
+		feederOwnsQueue.store(false, std::memory_order_release);
+		return false;
+	}
+	return true;
+}
+
 void gui_render()
 {
-	ImGui::Render();
-	ImGui_ImplOpenGL2_RenderDrawData(ImGui::GetDrawData());
+	// a skipped frame still holds the last frame's draw data, which stays valid until NewFrame
+	if (!frameSkipped)
+	{
+		ImGui::Render();
+	}
+	renderDrawData(ImGui::GetDrawData());
+}
+
+bool gui_take_click(int* x, int* y)
+{
+	if (!viewportClicked)
+	{
+		return false;
+	}
+	viewportClicked = false;
+	*x = clickX;
+	*y = clickY;
+	return true;
+}
+
+bool gui_viewport_drag(int* x, int* y)
+{
+	if (!viewportDrag.held)
+	{
+		return false;
+	}
+	*x = viewportDrag.x;
+	*y = viewportDrag.y;
+	return true;
+}
+
+void gui_select_axis(enum Axis axis)
+{
+	selectedAxis = axis;
+}
+
+void gui_set_known_state(bool known)
+{
+	setKnownRenderState(known);
+}
+
+bool gui_record(const char* path)
+{
+	endRecording(&recorder);
+	return beginRecording(&recorder, path);
+}
+
+bool gui_replay(const char* path, int repeat)
+{
+	// headless: the panel is still built every frame so its cost is measured, but never drawn
+	bool ownContext = ImGui::GetCurrentContext() == nullptr;
+	if (ownContext)
+	{
+		ImGui::CreateContext();
+		ImGuiIO& io = ImGui::GetIO();
+		io.DisplaySize = ImVec2(1200, 1200);
+		io.IniFilename = nullptr;
+		io.Fonts->Build();
+	}
+
+	bool replayed = true;
+	for (int ri = 0; ri < repeat && replayed; ++ri)
+	{
+		SessionPlayer player;
+		if (!openReplay(&player, path))
+		{
+			replayed = false;
+			break;
+		}
+
+		Gimbal gimbal = {};
+		Gimbal target = {};
+		Controller* replay = new Controller();
+		initController(replay, &gimbal, &target);
+		SessionInput input;
+		float result[3];
+		long long diverged = -1;
+		long long slowestFrame = 0;
+		double slowest = 0.0;
+		double total = 0.0;
+		while (readFrame(&player, &input, &gimbal, &target, result))
+		{
+			auto start = std::chrono::steady_clock::now();
+
+			// build the panel as the live frame did, then apply what was recorded in its place
+			Gimbal recordedGimbal = gimbal;
+			Gimbal recordedTarget = target;
+			ImGui::GetIO().DeltaTime = input.deltaTime > 0.0f ? input.deltaTime : 1e-6f;
+			ImGui::NewFrame();
+			buildPanel(replay);
+			gimbal = recordedGimbal;
+			target = recordedTarget;
+			replay->input = input;
+			applySession(&replay->session, &replay->input, &gimbal, &target);
+			ImGui::Render();
+
+			double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			total += elapsed;
+			if (elapsed > slowest)
+			{
+				slowest = elapsed;
+				slowestFrame = player.frames - 1;
+			}
+			if (diverged < 0 && memcmp(gimbal.rotation, result, sizeof(Vec3)) != 0)
+			{
+				diverged = player.frames - 1;
+			}
+		}
+
+		printf("replay %d: %lld frames in %.3f ms, slowest frame %lld took %.3f ms\n",
+			ri + 1, player.frames, total * 1e3, slowestFrame, slowest * 1e3);
+		if (diverged >= 0)
+		{
+			printf("replay %d: pose diverged from the recording at frame %lld\n", ri + 1, diverged);
+		}
+		closeReplay(&player);
+		delete replay;
+	}
+
+	if (ownContext)
+	{
+		ImGui::DestroyContext();
+	}
+	return replayed;
 }
 
 void gui_shutdown()
 {
+	stopWaypointFeeder(&waypointFeeder);
+	stopThreadPool(&pool);
+	for (size_t ci = 1; ci < controllers.size(); ++ci)
+	{
+		delete controllers[ci];
+	}
+	controllers.clear();
+	endRecording(&recorder);
+	closePoseViewer(&poseViewer);
+	releaseRenderer();
 	ImGui_ImplOpenGL2_Shutdown();
 	ImGui_ImplGLUT_Shutdown();
 	ImGui::DestroyContext();
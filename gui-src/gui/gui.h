@@ -1,5 +1,6 @@
 #pragma once
 #include "gimbal.h"
+#include <stddef.h>
 
 // Allow linkage to C code
 #ifdef __cplusplus
@@ -7,8 +8,53 @@ extern "C" {
 #endif
 
 void gui_init();
+// whether the next gui_update would build a new frame; false while there is no recent input and
+// nothing animating, when gui_update reuses the last frame instead
+bool gui_wants_update();
 void gui_update(Gimbal* gimbal, Gimbal* target);
+// adds another primary and target pair with a controller of its own, stepped alongside the first
+// on the gui's threads; a slider on the panel picks the pair it edits, and the gimbals must
+// outlive the gui
+void gui_add_pair(Gimbal* gimbal, Gimbal* target);
+// queues a target for the primary gimbal to rotate to once it reaches the current one; safe to call
+// from one thread other than the GUI thread, returns false if the queue is full or the feeder owns it
+bool gui_push_waypoint(const float rotation[3]);
+// queues the waypoints in a text file, or stdin for "-", from a thread of its own: an "x y z" line
+// of degrees is for the primary, and an "i x y z" line for gimbal i of the scene, if one was set
+// before the call. That thread becomes the queues' one producer, so it can only be called once, and
+// before any thread calls gui_push_waypoint, which is refused from then on
+bool gui_feed_waypoints(const char* path);
+// lists the gimbals in the outliner window, where they can be sorted, filtered and edited, and
+// rotates each towards its target on the gui's threads if targets are given; the arrays must
+// outlive the gui or be replaced by another call, and a count of zero hides the window
+void gui_set_scene(Gimbal* gimbals, const Gimbal* targets, size_t count);
+// highlights a gimbal of the scene in the outliner and scrolls its row into view, e.g. after it was
+// picked in the 3D view
+void gui_select_gimbal(size_t index);
+// maps a pose file, see posefile.h, and opens a window that plays it back onto the primary
+bool gui_open_poses(const char* path);
 void gui_render();
+// takes the last left click that landed outside the gui's windows, e.g. on the 3D view, if there
+// was one since the last call
+bool gui_take_click(int* x, int* y);
+// highlights an axis on the primary while none of its rotations is being dragged, e.g. a ring
+// picked in the 3D view; AXIS_NONE clears it
+void gui_select_axis(enum Axis axis);
+// while the left button is held after a press outside the gui's windows, gives the cursor's latest
+// position from the GLUT events that arrived before this frame
+bool gui_viewport_drag(int* x, int* y);
+// Promises that the caller sets all the GL state it draws with at the start of every frame, so
+// gui_render sets only what it needs and restores nothing, skipping the state queries that stall
+// the driver. The state it leaves behind is listed in renderer.h. Off by default.
+void gui_set_known_state(bool known);
+// logs the primary pair's panel input to the file every frame until shutdown, with the primary and
+// target poses the frame started from, see session.h. Nothing else is logged: outliner and scene
+// edits, the other pairs and the pose viewer aren't, and an arcball drag only shows up as the
+// primary pose the next frame starts from
+bool gui_record(const char* path);
+// replays the primary pair of a recorded session without a window, repeat times, printing frame
+// timings and the first frame whose pose differs from the recording
+bool gui_replay(const char* path, int repeat);
 void gui_shutdown();
 
 #ifdef __cplusplus
@@ -0,0 +1,61 @@
+#pragma once
+
+// Allow linkage to C code
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the parts of a frame that are timed; a phase may sit inside another, e.g. everything is inside
+// PROFILE_FRAME
+enum ProfilePhase
+{
+	PROFILE_FRAME,        // the whole of display()
+	PROFILE_GUI_UPDATE,
+	PROFILE_DRAW_GIMBALS,
+	PROFILE_GUI_RENDER,
+	PROFILE_PHASE_COUNT
+};
+
+#define PROFILE_HISTOGRAM_BUCKETS 32
+
+// statistics over the frames still held by the profiler, times in milliseconds
+typedef struct ProfileStats
+{
+	unsigned int frames;
+	float p50[PROFILE_PHASE_COUNT];
+	float p95[PROFILE_PHASE_COUNT];
+	float p99[PROFILE_PHASE_COUNT];
+	float worst[PROFILE_PHASE_COUNT];
+	// the slowest frame whole: how many frames ago it was, and its phases
+	unsigned int worstAge;
+	float worstFrame[PROFILE_PHASE_COUNT];
+	// frame counts by PROFILE_FRAME time, in even buckets from 0 to the worst frame
+	float histogram[PROFILE_HISTOGRAM_BUCKETS];
+	// input to flush latency over the frames that showed new input
+	unsigned int inputFrames;
+	float inputP50;
+	float inputP95;
+	float inputP99;
+	float inputWorst;
+} ProfileStats;
+
+// Phases are timed by the thread that draws, and a frame's times are published to the ring together
+// when it ends. Reading the stats never blocks that thread.
+void profiler_begin(enum ProfilePhase phase);
+void profiler_end(enum ProfilePhase phase);
+void profiler_end_frame();
+void profiler_stats(ProfileStats* stats);
+
+// Input latency: each input event is stamped as it arrives. The oldest stamp not yet shown is taken
+// up by the next frame to start, and its latency is closed when that frame is flushed or swapped,
+// so it covers the event waiting for the frame as well as the frame itself.
+void profiler_input();
+// called as a frame starts to take the input that arrived before it
+void profiler_take_input();
+void profiler_present();
+// writes the frames still held, one CSV row each with their phase times and input latency
+bool profiler_dump(const char* path);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,212 @@
+#include "outliner.h"
+#include <algorithm>
+#include <cstdio>
+
+static const char* modeNames[] = { "XYZ", "XZY", "YXZ", "YZX", "ZXY", "ZYX" };
+
+//--------------------------------------------------------------------------------------------------
+// prototypes
+//--------------------------------------------------------------------------------------------------
+
+static void gimbalName(size_t index, char* name, size_t size);
+static void rebuildOrder(Outliner* outliner);
+static void sortOrder(Outliner* outliner);
+
+//--------------------------------------------------------------------------------------------------
+// outliner
+//--------------------------------------------------------------------------------------------------
+
+void setOutlinerScene(Outliner* outliner, Gimbal* gimbals, size_t count)
+{
+	outliner->gimbals = gimbals;
+	outliner->count = count;
+	outliner->stale = true;
+	outliner->selected = SIZE_MAX;
+	outliner->revealSelected = false;
+}
+
+void selectOutlinerGimbal(Outliner* outliner, size_t index)
+{
+	outliner->selected = index < outliner->count ? index : SIZE_MAX;
+	outliner->revealSelected = outliner->selected != SIZE_MAX;
+}
+
+void buildOutliner(Outliner* outliner)
+{
+	outliner->edited.clear();
+	if ( outliner->gimbals == nullptr || outliner->count == 0 )
+	{
+		return;
+	}
+
+	ImGui::SetNextWindowPos(ImVec2(300, 10), ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowSize(ImVec2(360, 400), ImGuiCond_FirstUseEver);
+	if ( !ImGui::Begin("Outliner") )
+	{
+		ImGui::End();
+		return;
+	}
+
+	ImGui::SetNextItemWidth(-90.0f);
+	if ( outliner->filter.Draw("##filter") )
+	{
+		outliner->stale = true;
+	}
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(-FLT_MIN);
+	if ( ImGui::Combo("##mode_filter", &outliner->modeFilter, "All\0XYZ\0XZY\0YXZ\0YZX\0ZXY\0ZYX\0") )
+	{
+		outliner->stale = true;
+	}
+	ImGui::Text("%zu of %zu gimbals", outliner->order.size(), outliner->count);
+
+	ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_Sortable | ImGuiTableFlags_RowBg
+		| ImGuiTableFlags_BordersOuter | ImGuiTableFlags_BordersV | ImGuiTableFlags_Resizable;
+	if ( ImGui::BeginTable("##outliner", OUTLINER_COLUMN_COUNT, flags) )
+	{
+		ImGui::TableSetupScrollFreeze(0, 1);
+		ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_DefaultSort, 0.0f, OUTLINER_INDEX);
+		ImGui::TableSetupColumn("X", 0, 0.0f, OUTLINER_X);
+		ImGui::TableSetupColumn("Y", 0, 0.0f, OUTLINER_Y);
+		ImGui::TableSetupColumn("Z", 0, 0.0f, OUTLINER_Z);
+		ImGui::TableSetupColumn("Mode", 0, 0.0f, OUTLINER_MODE);
+		ImGui::TableHeadersRow();
+
+		// sorted once when asked, not every frame; edited values keep their row until the next sort
+		// so a row doesn't jump out from under the mouse
+		ImGuiTableSortSpecs* sortSpecs = ImGui::TableGetSortSpecs();
+		bool resort = false;
+		if ( sortSpecs != nullptr && sortSpecs->SpecsDirty && sortSpecs->SpecsCount > 0 )
+		{
+			outliner->sortColumn = (int) sortSpecs->Specs[0].ColumnUserID;
+			outliner->sortDescending = sortSpecs->Specs[0].SortDirection == ImGuiSortDirection_Descending;
+			sortSpecs->SpecsDirty = false;
+			resort = true;
+		}
+		if ( outliner->stale )
+		{
+			rebuildOrder(outliner);
+		}
+		else if ( resort )
+		{
+			sortOrder(outliner);
+		}
+
+		// the selected row is never clipped on the frame it is revealed, so it can be scrolled to
+		int revealRow = -1;
+		if ( outliner->revealSelected )
+		{
+			std::vector<uint32_t>::const_iterator found = std::find(outliner->order.begin(), outliner->order.end(), (uint32_t) outliner->selected);
+			revealRow = found != outliner->order.end() ? (int) (found - outliner->order.begin()) : -1;
+			outliner->revealSelected = false;
+		}
+
+		ImGuiListClipper clipper;
+		clipper.Begin((int) outliner->order.size());
+		if ( revealRow >= 0 )
+		{
+			clipper.IncludeRangeByIndices(revealRow, revealRow + 1);
+		}
+		while ( clipper.Step() )
+		{
+			for ( int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row )
+			{
+				uint32_t index = outliner->order[row];
+				Gimbal* gimbal = &outliner->gimbals[index];
+				ImGui::PushID((int) index);
+				ImGui::TableNextRow();
+
+				ImGui::TableNextColumn();
+				char name[32];
+				gimbalName(index, name, sizeof(name));
+				// the name selects the row, whose highlight runs under the angles without taking their clicks
+				if ( ImGui::Selectable(name, index == outliner->selected, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowOverlap) )
+				{
+					outliner->selected = index;
+				}
+				if ( row == revealRow )
+				{
+					ImGui::SetScrollHereY(0.5f);
+				}
+				for ( int axis = AXIS_X; axis <= AXIS_Z; ++axis )
+				{
+					ImGui::TableNextColumn();
+					ImGui::SetNextItemWidth(-FLT_MIN);
+					ImGui::PushID(axis);
+					float angle = gimbal->rotation[axis];
+					if ( ImGui::DragFloat("##angle", &angle, 1.0f, -180.0f, 180.0f, "%.1f", ImGuiSliderFlags_AlwaysClamp) )
+					{
+						gimbal->rotation[axis] = angle;
+						outliner->edited.push_back(index);
+					}
+					ImGui::PopID();
+				}
+
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(modeNames[gimbal->eulerMode]);
+				ImGui::PopID();
+			}
+		}
+		ImGui::EndTable();
+	}
+	ImGui::End();
+}
+
+static void gimbalName(size_t index, char* name, size_t size)
+{
+	snprintf(name, size, "Gimbal %zu", index);
+}
+
+// filters the whole scene into the order array, then sorts it
+static void rebuildOrder(Outliner* outliner)
+{
+	outliner->order.clear();
+	outliner->order.reserve(outliner->count);
+	char name[32];
+	for ( size_t gi = 0; gi < outliner->count; ++gi )
+	{
+		if ( outliner->modeFilter > 0 && outliner->gimbals[gi].eulerMode != outliner->modeFilter - 1 )
+		{
+			continue;
+		}
+		if ( outliner->filter.IsActive() )
+		{
+			gimbalName(gi, name, sizeof(name));
+			if ( !outliner->filter.PassFilter(name) )
+			{
+				continue;
+			}
+		}
+		outliner->order.push_back((uint32_t) gi);
+	}
+	outliner->stale = false;
+	sortOrder(outliner);
+}
+
+static void sortOrder(Outliner* outliner)
+{
+	const Gimbal* gimbals = outliner->gimbals;
+	int column = outliner->sortColumn;
+	bool descending = outliner->sortDescending;
+	std::sort(outliner->order.begin(), outliner->order.end(), [gimbals, column, descending](uint32_t a, uint32_t b)
+	{
+		float keyA = 0.0f;
+		float keyB = 0.0f;
+		if ( column >= OUTLINER_X && column <= OUTLINER_Z )
+		{
+			keyA = gimbals[a].rotation[column - OUTLINER_X];
+			keyB = gimbals[b].rotation[column - OUTLINER_X];
+		}
+		else if ( column == OUTLINER_MODE )
+		{
+			keyA = (float) gimbals[a].eulerMode;
+			keyB = (float) gimbals[b].eulerMode;
+		}
+		// ties fall back to the index so the order is stable between sorts
+		if ( keyA == keyB )
+		{
+			return descending ? a > b : a < b;
+		}
+		return descending ? keyA > keyB : keyA < keyB;
+	});
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "gimbal.h"
+#include <imgui.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum OutlinerColumn
+{
+	OUTLINER_INDEX,
+	OUTLINER_X,
+	OUTLINER_Y,
+	OUTLINER_Z,
+	OUTLINER_MODE,
+	OUTLINER_COLUMN_COUNT
+};
+
+// A table of every gimbal in a scene. Filtering and sorting only ever rearrange the order array,
+// the gimbals stay where their owner put them, and only the rows scrolled into view are submitted,
+// so the panel costs the same for a hundred gimbals as for a hundred thousand.
+struct Outliner
+{
+	Gimbal* gimbals;
+	size_t count;
+	std::vector<uint32_t> order; // indices of the gimbals listed, filtered then sorted
+	ImGuiTextFilter filter;      // on the gimbal names
+	int modeFilter;              // 0 for all, otherwise an EulerMode + 1
+	int sortColumn;
+	bool sortDescending;
+	bool stale;                  // the order needs building again
+	std::vector<uint32_t> edited; // gimbals whose rotation was edited in the last build
+	size_t selected;              // the highlighted gimbal, SIZE_MAX for none
+	bool revealSelected;          // scroll its row into view on the next build
+};
+
+void setOutlinerScene(Outliner* outliner, Gimbal* gimbals, size_t count);
+// highlights a gimbal's row and scrolls to it, if the filters list it
+void selectOutlinerGimbal(Outliner* outliner, size_t index);
+// the window, if a scene has been set
+void buildOutliner(Outliner* outliner);
@@ -0,0 +1,155 @@
+#include "poseviewer.h"
+#include <imgui.h>
+#include <algorithm>
+
+// how many chunks before the one holding a time are searched for a gimbal's latest pose
+#define POSE_LOOK_BACK 1
+
+//--------------------------------------------------------------------------------------------------
+// prototypes
+//--------------------------------------------------------------------------------------------------
+
+static void holdChunks(PoseViewer* viewer, size_t first, size_t end);
+static void samplePlot(PoseViewer* viewer, double start);
+
+//--------------------------------------------------------------------------------------------------
+// pose viewer
+//--------------------------------------------------------------------------------------------------
+
+bool openPoseViewer(PoseViewer* viewer, const char* path)
+{
+	closePoseViewer(viewer);
+	if ( !openPoseFile(&viewer->file, path) )
+	{
+		return false;
+	}
+	if ( viewer->file.chunkCount == 0 )
+	{
+		closePoseFile(&viewer->file);
+		return false;
+	}
+
+	viewer->open = true;
+	viewer->time = viewer->file.index[0].firstTime;
+	viewer->window = 10.0f;
+	viewer->gimbal = 0;
+	viewer->playing = false;
+	viewer->drive = true;
+	viewer->firstChunk = 0;
+	viewer->endChunk = 0;
+	return true;
+}
+
+void closePoseViewer(PoseViewer* viewer)
+{
+	if ( viewer->open )
+	{
+		closePoseFile(&viewer->file);
+	}
+	viewer->open = false;
+	viewer->playing = false;
+}
+
+void buildPoseViewer(PoseViewer* viewer, Gimbal* gimbal, float deltaTime)
+{
+	if ( !viewer->open )
+	{
+		return;
+	}
+
+	const PoseFile* file = &viewer->file;
+	double firstTime = file->index[0].firstTime;
+	double lastTime = file->index[file->chunkCount - 1].lastTime;
+	if ( viewer->playing )
+	{
+		viewer->time += deltaTime;
+		if ( viewer->time >= lastTime )
+		{
+			viewer->time = lastTime;
+			viewer->playing = false;
+		}
+	}
+
+	// only the chunks under the window are touched, everything else is handed back
+	double start = viewer->time - 0.5 * viewer->window;
+	double end = viewer->time + 0.5 * viewer->window;
+	size_t first = findPoseChunk(file, start);
+	first = first > POSE_LOOK_BACK ? first - POSE_LOOK_BACK : 0;
+	holdChunks(viewer, first, findPoseChunk(file, end) + 1);
+
+	float rotation[3];
+	enum EulerMode eulerMode;
+	if ( viewer->drive && samplePose(file, (uint32_t) viewer->gimbal, viewer->time, POSE_LOOK_BACK, rotation, &eulerMode) )
+	{
+		gimbal->rotation[0] = rotation[0];
+		gimbal->rotation[1] = rotation[1];
+		gimbal->rotation[2] = rotation[2];
+		gimbal->eulerMode = eulerMode;
+	}
+
+	ImGui::SetNextWindowPos(ImVec2(670, 10), ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowSize(ImVec2(360, 330), ImGuiCond_FirstUseEver);
+	if ( !ImGui::Begin("Poses") )
+	{
+		ImGui::End();
+		return;
+	}
+
+	ImGui::Text("%llu frames in %zu chunks, %.2f GB", (unsigned long long) file->frameCount, file->chunkCount, (double) file->mapped.size / 1e9);
+	ImGui::TextDisabled("%zu chunks held for the window", viewer->endChunk - viewer->firstChunk);
+
+	ImGui::SetNextItemWidth(-FLT_MIN);
+	ImGui::SliderScalar("##pose_time", ImGuiDataType_Double, &viewer->time, &firstTime, &lastTime, "%.3f s");
+	ImGui::Checkbox("Play", &viewer->playing);
+	ImGui::SameLine();
+	ImGui::Checkbox("Drive primary", &viewer->drive);
+	ImGui::PushItemWidth(120.0f);
+	ImGui::DragFloat("Window", &viewer->window, 0.1f, 0.01f, 3600.0f, "%.2f s", ImGuiSliderFlags_AlwaysClamp | ImGuiSliderFlags_Logarithmic);
+	if ( ImGui::InputInt("Gimbal", &viewer->gimbal) )
+	{
+		viewer->gimbal = std::max(viewer->gimbal, 0);
+	}
+	ImGui::PopItemWidth();
+
+	samplePlot(viewer, start);
+	static const char* axisNames[3] = { "X", "Y", "Z" };
+	for ( int ai = 0; ai < 3; ++ai )
+	{
+		ImGui::PlotLines(axisNames[ai], viewer->plot[ai], POSE_PLOT_SAMPLES, 0, nullptr, -180.0f, 180.0f, ImVec2(-20.0f, 50.0f));
+	}
+	ImGui::End();
+}
+
+// releases the chunks that have left [first, end)
+static void holdChunks(PoseViewer* viewer, size_t first, size_t end)
+{
+	size_t heldFirst = viewer->firstChunk;
+	size_t heldEnd = viewer->endChunk;
+	if ( first > heldFirst )
+	{
+		releasePoseChunks(&viewer->file, heldFirst, std::min(first, heldEnd) - heldFirst);
+	}
+	if ( end < heldEnd )
+	{
+		size_t from = std::max(end, heldFirst);
+		releasePoseChunks(&viewer->file, from, heldEnd - from);
+	}
+	viewer->firstChunk = first;
+	viewer->endChunk = end;
+}
+
+// the gimbal's angles across the window, holding the last pose where it has none
+static void samplePlot(PoseViewer* viewer, double start)
+{
+	float rotation[3] = { 0.0f, 0.0f, 0.0f };
+	enum EulerMode eulerMode;
+	for ( int si = 0; si < POSE_PLOT_SAMPLES; ++si )
+	{
+		double time = start + viewer->window * si / (POSE_PLOT_SAMPLES - 1);
+		samplePose(&viewer->file, (uint32_t) viewer->gimbal, time, POSE_LOOK_BACK, rotation, &eulerMode);
+		for ( int ai = 0; ai < 3; ++ai )
+		{
+			viewer->plot[ai][si] = rotation[ai];
+		}
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "gimbal.h"
+#include "posefile.h"
+
+#define POSE_PLOT_SAMPLES 256
+
+// Plays back a pose file onto the primary. Only the chunks around the time being viewed are ever
+// touched, and chunks are handed back to the OS as they leave the window, so the memory held stays
+// bounded by the window however long the file is.
+struct PoseViewer
+{
+	PoseFile file;
+	bool open;
+	double time;
+	float window;      // seconds shown around the time
+	int gimbal;        // the id played back
+	bool playing;
+	bool drive;        // whether the primary follows the file
+	size_t firstChunk; // the chunks held in memory, [first, end)
+	size_t endChunk;
+	float plot[3][POSE_PLOT_SAMPLES];
+};
+
+bool openPoseViewer(PoseViewer* viewer, const char* path);
+void closePoseViewer(PoseViewer* viewer);
+// the window, if a file is open; sets the gimbal's pose while driving it
+void buildPoseViewer(PoseViewer* viewer, Gimbal* gimbal, float deltaTime);
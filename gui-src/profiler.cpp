@@ -0,0 +1,218 @@
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// frames kept, a power of two so the ring index is a mask
+#define PROFILE_CAPACITY 1024
+
+struct ProfileFrame
+{
+	float ms[PROFILE_PHASE_COUNT];
+	float inputMs;           // negative when the frame showed no new input
+	unsigned int inputEvents;
+};
+
+typedef std::chrono::steady_clock ProfileClock;
+
+// written only by the drawing thread
+static ProfileClock::time_point phaseStart[PROFILE_PHASE_COUNT];
+static ProfileFrame current = { {}, -1.0f, 0 };
+
+// the oldest input not yet taken by a frame, and the one the current frame took
+static ProfileClock::time_point pendingInput;
+static unsigned int pendingEvents = 0;
+static ProfileClock::time_point frameInput;
+static unsigned int frameEvents = 0;
+
+// the ring, and how many frames have ever been published to it
+static ProfileFrame ring[PROFILE_CAPACITY];
+static std::atomic<uint64_t> published(0);
+
+//--------------------------------------------------------------------------------------------------
+// prototypes
+//--------------------------------------------------------------------------------------------------
+
+static unsigned int copyFrames(const ProfileFrame** frames, uint64_t* first);
+static float percentile(float* values, unsigned int count, float fraction);
+
+//--------------------------------------------------------------------------------------------------
+// timing
+//--------------------------------------------------------------------------------------------------
+
+void profiler_begin(enum ProfilePhase phase)
+{
+	phaseStart[phase] = ProfileClock::now();
+}
+
+void profiler_end(enum ProfilePhase phase)
+{
+	// a phase run more than once in a frame adds up
+	current.ms[phase] += std::chrono::duration<float, std::milli>(ProfileClock::now() - phaseStart[phase]).count();
+}
+
+void profiler_end_frame()
+{
+	uint64_t frame = published.load(std::memory_order_relaxed);
+	ring[frame & (PROFILE_CAPACITY - 1)] = current;
+	published.store(frame + 1, std::memory_order_release);
+	current = {};
+	current.inputMs = -1.0f;
+}
+
+void profiler_input()
+{
+	if ( pendingEvents == 0 )
+	{
+		pendingInput = ProfileClock::now();
+	}
+	pendingEvents++;
+}
+
+void profiler_take_input()
+{
+	frameInput = pendingInput;
+	frameEvents = pendingEvents;
+	pendingEvents = 0;
+}
+
+void profiler_present()
+{
+	if ( frameEvents == 0 )
+	{
+		return;
+	}
+	current.inputMs = std::chrono::duration<float, std::milli>(ProfileClock::now() - frameInput).count();
+	current.inputEvents = frameEvents;
+	frameEvents = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+// stats
+//--------------------------------------------------------------------------------------------------
+
+void profiler_stats(ProfileStats* stats)
+{
+	*stats = {};
+
+	const ProfileFrame* valid;
+	uint64_t first;
+	unsigned int count = copyFrames(&valid, &first);
+	if ( count == 0 )
+	{
+		return;
+	}
+	stats->frames = count;
+
+	unsigned int worst = 0;
+	for ( unsigned int fi = 1; fi < count; ++fi )
+	{
+		if ( valid[fi].ms[PROFILE_FRAME] > valid[worst].ms[PROFILE_FRAME] )
+		{
+			worst = fi;
+		}
+	}
+	stats->worstAge = count - 1 - worst;
+
+	static float values[PROFILE_CAPACITY];
+	unsigned int inputCount = 0;
+	for ( unsigned int fi = 0; fi < count; ++fi )
+	{
+		if ( valid[fi].inputMs >= 0.0f )
+		{
+			values[inputCount++] = valid[fi].inputMs;
+		}
+	}
+	stats->inputFrames = inputCount;
+	if ( inputCount > 0 )
+	{
+		stats->inputWorst = *std::max_element(values, values + inputCount);
+		stats->inputP50 = percentile(values, inputCount, 0.50f);
+		stats->inputP95 = percentile(values, inputCount, 0.95f);
+		stats->inputP99 = percentile(values, inputCount, 0.99f);
+	}
+
+	for ( int pi = 0; pi < PROFILE_PHASE_COUNT; ++pi )
+	{
+		stats->worstFrame[pi] = valid[worst].ms[pi];
+		for ( unsigned int fi = 0; fi < count; ++fi )
+		{
+			values[fi] = valid[fi].ms[pi];
+		}
+		stats->worst[pi] = *std::max_element(values, values + count);
+		stats->p50[pi] = percentile(values, count, 0.50f);
+		stats->p95[pi] = percentile(values, count, 0.95f);
+		stats->p99[pi] = percentile(values, count, 0.99f);
+	}
+
+	float bucketWidth = stats->worst[PROFILE_FRAME] / PROFILE_HISTOGRAM_BUCKETS;
+	for ( unsigned int fi = 0; fi < count; ++fi )
+	{
+		int bucket = bucketWidth > 0.0f ? (int) (valid[fi].ms[PROFILE_FRAME] / bucketWidth) : 0;
+		stats->histogram[std::min(bucket, PROFILE_HISTOGRAM_BUCKETS - 1)] += 1.0f;
+	}
+}
+
+bool profiler_dump(const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if ( file == nullptr )
+	{
+		return false;
+	}
+
+	// frames are numbered from the first ever profiled; input latency is empty for frames without input
+	const ProfileFrame* frames;
+	uint64_t first;
+	unsigned int count = copyFrames(&frames, &first);
+	fprintf(file, "frame,frame_ms,gui_update_ms,draw_gimbals_ms,gui_render_ms,input_latency_ms,input_events\n");
+	for ( unsigned int fi = 0; fi < count; ++fi )
+	{
+		const ProfileFrame* frame = &frames[fi];
+		fprintf(file, "%llu", (unsigned long long) (first + fi));
+		for ( int pi = 0; pi < PROFILE_PHASE_COUNT; ++pi )
+		{
+			fprintf(file, ",%.4f", frame->ms[pi]);
+		}
+		if ( frame->inputMs >= 0.0f )
+		{
+			fprintf(file, ",%.4f,%u\n", frame->inputMs, frame->inputEvents);
+		}
+		else
+		{
+			fprintf(file, ",,0\n");
+		}
+	}
+	return fclose(file) == 0;
+}
+
+// copies the ring out, then drops whatever the drawing thread overwrote while it was copied; the
+// copy is only good until the next call
+static unsigned int copyFrames(const ProfileFrame** frames, uint64_t* first)
+{
+	static ProfileFrame copy[PROFILE_CAPACITY];
+	uint64_t end = published.load(std::memory_order_acquire);
+	uint64_t begin = end > PROFILE_CAPACITY ? end - PROFILE_CAPACITY : 0;
+	for ( uint64_t fi = begin; fi < end; ++fi )
+	{
+		copy[fi - begin] = ring[fi & (PROFILE_CAPACITY - 1)];
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+	// the slot of the frame after the last published one may be mid-write as well
+	uint64_t after = published.load(std::memory_order_relaxed);
+	uint64_t firstValid = after + 1 > PROFILE_CAPACITY ? after + 1 - PROFILE_CAPACITY : 0;
+	uint64_t skip = std::min(std::max(firstValid, begin), end) - begin;
+	*frames = copy + skip;
+	*first = begin + skip;
+	return (unsigned int) (end - begin - skip);
+}
+
+// nearest-rank percentile; reorders values
+static float percentile(float* values, unsigned int count, float fraction)
+{
+	float* nth = values + (unsigned int) (fraction * (count - 1) + 0.5f);
+	std::nth_element(values, nth, values + count);
+	return *nth;
+}
@@ -0,0 +1,247 @@
+#include "renderer.h"
+#include "extensions.h"
+#include <backends/imgui_impl_opengl2.h>
+#include <cstdint>
+
+// the stream buffers, grown to fit the largest frame so far
+struct StreamBuffers
+{
+	GLuint vertexBuffer;
+	GLuint indexBuffer;
+	GLsizeiptr vertexCapacity;
+	GLsizeiptr indexCapacity;
+};
+
+static StreamBuffers streams = { 0, 0, 0, 0 };
+static bool knownState = false;
+
+//--------------------------------------------------------------------------------------------------
+// prototypes
+//--------------------------------------------------------------------------------------------------
+
+static void uploadDrawData(const ImDrawData* drawData);
+static void setupRenderState(const ImDrawData* drawData, int width, int height);
+static void endRenderState();
+static void bindVertices(GLintptr vertexOffset);
+
+//--------------------------------------------------------------------------------------------------
+// renderer
+//--------------------------------------------------------------------------------------------------
+
+void renderDrawData(ImDrawData* drawData)
+{
+	if ( !hasBuffers() )
+	{
+		ImGui_ImplOpenGL2_RenderDrawData(drawData);
+		return;
+	}
+
+	// nothing to draw into while minimised
+	int width = (int)(drawData->DisplaySize.x * drawData->FramebufferScale.x);
+	int height = (int)(drawData->DisplaySize.y * drawData->FramebufferScale.y);
+	if ( width == 0 || height == 0 || drawData->TotalVtxCount == 0 )
+	{
+		return;
+	}
+
+	uploadDrawData(drawData);
+
+	// the same state the stock renderer saves and restores, each query a round trip to the driver
+	GLint lastTexture = 0;
+	GLint lastPolygonMode[2] = { GL_FILL, GL_FILL };
+	GLint lastViewport[4] = {};
+	GLint lastScissorBox[4] = {};
+	GLint lastShadeModel = GL_SMOOTH;
+	GLint lastTexEnvMode = GL_MODULATE;
+	if ( !knownState )
+	{
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &lastTexture);
+		glGetIntegerv(GL_POLYGON_MODE, lastPolygonMode);
+		glGetIntegerv(GL_VIEWPORT, lastViewport);
+		glGetIntegerv(GL_SCISSOR_BOX, lastScissorBox);
+		glGetIntegerv(GL_SHADE_MODEL, &lastShadeModel);
+		glGetTexEnviv(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, &lastTexEnvMode);
+		glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_TRANSFORM_BIT);
+	}
+	setupRenderState(drawData, width, height);
+
+	ImVec2 clipOffset = drawData->DisplayPos;
+	ImVec2 clipScale = drawData->FramebufferScale;
+	GLintptr vertexOffset = 0;
+	GLintptr indexOffset = 0;
+	for ( int li = 0; li < drawData->CmdListsCount; ++li )
+	{
+		const ImDrawList* list = drawData->CmdLists[li];
+		bindVertices(vertexOffset);
+		for ( const ImDrawCmd& command : list->CmdBuffer )
+		{
+			if ( command.UserCallback != nullptr )
+			{
+				if ( command.UserCallback == ImDrawCallback_ResetRenderState )
+				{
+					endRenderState();
+					setupRenderState(drawData, width, height);
+				}
+				else
+				{
+					command.UserCallback(list, &command);
+				}
+				// the callback may have bound buffers of its own
+				bindVertices(vertexOffset);
+				continue;
+			}
+
+			// scissor to the clip rectangle in framebuffer space, gl's y runs upwards
+			ImVec2 clipMin((command.ClipRect.x - clipOffset.x) * clipScale.x, (command.ClipRect.y - clipOffset.y) * clipScale.y);
+			ImVec2 clipMax((command.ClipRect.z - clipOffset.x) * clipScale.x, (command.ClipRect.w - clipOffset.y) * clipScale.y);
+			if ( clipMax.x <= clipMin.x || clipMax.y <= clipMin.y )
+			{
+				continue;
+			}
+			glScissor((int)clipMin.x, (int)((float)height - clipMax.y), (int)(clipMax.x - clipMin.x), (int)(clipMax.y - clipMin.y));
+
+			glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)command.GetTexID());
+			glDrawElements(GL_TRIANGLES, (GLsizei)command.ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,
+				(const GLvoid*)(indexOffset + command.IdxOffset * sizeof(ImDrawIdx)));
+		}
+		vertexOffset += list->VtxBuffer.Size * sizeof(ImDrawVert);
+		indexOffset += list->IdxBuffer.Size * sizeof(ImDrawIdx);
+	}
+
+	// client arrays elsewhere must not read from the stream buffers
+	extBindBuffer(GL_ARRAY_BUFFER, 0);
+	extBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	endRenderState();
+	if ( knownState )
+	{
+		return;
+	}
+
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glBindTexture(GL_TEXTURE_2D, (GLuint)lastTexture);
+	glPopAttrib();
+	glPolygonMode(GL_FRONT, (GLenum)lastPolygonMode[0]);
+	glPolygonMode(GL_BACK, (GLenum)lastPolygonMode[1]);
+	glViewport(lastViewport[0], lastViewport[1], (GLsizei)lastViewport[2], (GLsizei)lastViewport[3]);
+	glScissor(lastScissorBox[0], lastScissorBox[1], (GLsizei)lastScissorBox[2], (GLsizei)lastScissorBox[3]);
+	glShadeModel(lastShadeModel);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, lastTexEnvMode);
+}
+
+void setKnownRenderState(bool known)
+{
+	knownState = known;
+}
+
+void releaseRenderer()
+{
+	if ( streams.vertexBuffer != 0 )
+	{
+		extDeleteBuffers(1, &streams.vertexBuffer);
+		extDeleteBuffers(1, &streams.indexBuffer);
+	}
+	streams = { 0, 0, 0, 0 };
+}
+
+// copies every command list into the stream buffers, one after another
+static void uploadDrawData(const ImDrawData* drawData)
+{
+	if ( streams.vertexBuffer == 0 )
+	{
+		extGenBuffers(1, &streams.vertexBuffer);
+		extGenBuffers(1, &streams.indexBuffer);
+	}
+
+	GLsizeiptr vertexSize = drawData->TotalVtxCount * sizeof(ImDrawVert);
+	GLsizeiptr indexSize = drawData->TotalIdxCount * sizeof(ImDrawIdx);
+	// grow with headroom so a slowly growing ui doesn't reallocate every frame
+	while ( streams.vertexCapacity < vertexSize )
+	{
+		streams.vertexCapacity = streams.vertexCapacity > 0 ? streams.vertexCapacity * 2 : 64 * 1024;
+	}
+	while ( streams.indexCapacity < indexSize )
+	{
+		streams.indexCapacity = streams.indexCapacity > 0 ? streams.indexCapacity * 2 : 32 * 1024;
+	}
+
+	// orphaning hands back fresh storage rather than stalling on draws still reading the old
+	extBindBuffer(GL_ARRAY_BUFFER, streams.vertexBuffer);
+	extBufferData(GL_ARRAY_BUFFER, streams.vertexCapacity, nullptr, GL_STREAM_DRAW);
+	extBindBuffer(GL_ELEMENT_ARRAY_BUFFER, streams.indexBuffer);
+	extBufferData(GL_ELEMENT_ARRAY_BUFFER, streams.indexCapacity, nullptr, GL_STREAM_DRAW);
+
+	GLintptr vertexOffset = 0;
+	GLintptr indexOffset = 0;
+	for ( int li = 0; li < drawData->CmdListsCount; ++li )
+	{
+		const ImDrawList* list = drawData->CmdLists[li];
+		GLsizeiptr listVertices = list->VtxBuffer.Size * sizeof(ImDrawVert);
+		GLsizeiptr listIndices = list->IdxBuffer.Size * sizeof(ImDrawIdx);
+		extBufferSubData(GL_ARRAY_BUFFER, vertexOffset, listVertices, list->VtxBuffer.Data);
+		extBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indexOffset, listIndices, list->IdxBuffer.Data);
+		vertexOffset += listVertices;
+		indexOffset += listIndices;
+	}
+}
+
+static void setupRenderState(const ImDrawData* drawData, int width, int height)
+{
+	// alpha blending, no culling or depth, scissored, textured and unlit, as the stock renderer
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDisable(GL_CULL_FACE);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_STENCIL_TEST);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_COLOR_MATERIAL);
+	glEnable(GL_SCISSOR_TEST);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glEnable(GL_TEXTURE_2D);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	glShadeModel(GL_SMOOTH);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+	// orthographic over the display, y down; the caller's matrices are kept unless it has taken
+	// on setting its own each frame
+	glViewport(0, 0, (GLsizei)width, (GLsizei)height);
+	glMatrixMode(GL_PROJECTION);
+	if ( !knownState )
+	{
+		glPushMatrix();
+	}
+	glLoadIdentity();
+	glOrtho(drawData->DisplayPos.x, drawData->DisplayPos.x + drawData->DisplaySize.x,
+		drawData->DisplayPos.y + drawData->DisplaySize.y, drawData->DisplayPos.y, -1.0f, 1.0f);
+	glMatrixMode(GL_MODELVIEW);
+	if ( !knownState )
+	{
+		glPushMatrix();
+	}
+	glLoadIdentity();
+}
+
+static void endRenderState()
+{
+	if ( !knownState )
+	{
+		glMatrixMode(GL_MODELVIEW);
+		glPopMatrix();
+		glMatrixMode(GL_PROJECTION);
+		glPopMatrix();
+	}
+}
+
+// points the vertex arrays at one command list's vertices within the stream buffer
+static void bindVertices(GLintptr vertexOffset)
+{
+	extBindBuffer(GL_ARRAY_BUFFER, streams.vertexBuffer);
+	extBindBuffer(GL_ELEMENT_ARRAY_BUFFER, streams.indexBuffer);
+	glVertexPointer(2, GL_FLOAT, sizeof(ImDrawVert), (const GLvoid*)(vertexOffset + IM_OFFSETOF(ImDrawVert, pos)));
+	glTexCoordPointer(2, GL_FLOAT, sizeof(ImDrawVert), (const GLvoid*)(vertexOffset + IM_OFFSETOF(ImDrawVert, uv)));
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(ImDrawVert), (const GLvoid*)(vertexOffset + IM_OFFSETOF(ImDrawVert, col)));
+}
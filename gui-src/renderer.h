@@ -0,0 +1,14 @@
+#pragma once
+#include <imgui.h>
+
+// Draws ImGui's output from buffer objects rather than client memory. Each frame the buffers are
+// orphaned and every command list is uploaded into them once, so the driver neither copies the
+// arrays again on every draw call nor waits on the previous frame still reading them. Without
+// buffer objects (before GL 1.5 and ARB_vertex_buffer_object) it falls back to the stock renderer.
+void renderDrawData(ImDrawData* drawData);
+// Under the known-state contract the caller sets up all of its own GL state at the start of every
+// frame, so the streaming path reads nothing back and restores nothing. It leaves blending,
+// scissoring and 2D texturing on; depth testing, culling and lighting off; its own matrices and
+// viewport; and the vertex, colour and texture coordinate arrays enabled. Off by default.
+void setKnownRenderState(bool known);
+void releaseRenderer();
@@ -0,0 +1,434 @@
+#include "session.h"
+#include <cmath>
+#include <cstring>
+
+#define SESSION_MAGIC "GSES"
+#define SESSION_VERSION 1
+// keys added at the same time are pushed apart by at least this much
+#define MIN_KEY_SPACING 0.1
+
+enum SessionField
+{
+	FIELD_DELTA_TIME,
+	FIELD_PRIMARY_X,
+	FIELD_PRIMARY_Y,
+	FIELD_PRIMARY_Z,
+	FIELD_PRIMARY_ALPHA,
+	FIELD_PRIMARY_FLAGS,
+	FIELD_TARGET_X,
+	FIELD_TARGET_Y,
+	FIELD_TARGET_Z,
+	FIELD_TARGET_ALPHA,
+	FIELD_TARGET_FLAGS,
+	FIELD_SPEED,
+	FIELD_STEP_RATE,
+	FIELD_MODE,
+	FIELD_EASING,
+	FIELD_BEZIER_X1,
+	FIELD_BEZIER_Y1,
+	FIELD_BEZIER_X2,
+	FIELD_BEZIER_Y2,
+	FIELD_OPTIONS,
+	FIELD_INTERPOLATION,
+	FIELD_ACTIONS,
+	FIELD_SEEK_TIME,
+	FIELD_WAYPOINT_X,
+	FIELD_WAYPOINT_Y,
+	FIELD_WAYPOINT_Z,
+	FIELD_RESULT_X,
+	FIELD_RESULT_Y,
+	FIELD_RESULT_Z,
+	FIELD_COUNT
+};
+
+//--------------------------------------------------------------------------------------------------
+// session
+//--------------------------------------------------------------------------------------------------
+
+void resetSession(Session* session)
+{
+	resetClock(&session->clock);
+	session->clock.stepRate = DEFAULT_STEP_RATE;
+	session->clock.bakeCache = nullptr;
+	session->clock.easing = EASING_LINEAR;
+	initBezierEasing(&session->bezier);
+	session->clock.bezier = &session->bezier;
+	session->bakeCache.budget = DEFAULT_BAKE_BUDGET;
+	clearBakeCache(&session->bakeCache);
+	clearTimeline(&session->timeline);
+	session->timeline.interpolation = INTERPOLATE_LINEAR;
+	session->animate = false;
+	session->hasWaypoint = false;
+
+	SessionInput& settings = session->settings;
+	memset(&settings, 0, sizeof(settings));
+	settings.rotationDegPerSecond = 6.0f;
+	settings.stepRate = DEFAULT_STEP_RATE;
+	settings.animationMode = ANIMATION_SEQUENTIAL;
+	settings.easing = EASING_LINEAR;
+	memcpy(settings.bezier, session->bezier.controls, sizeof(settings.bezier));
+}
+
+bool isTimelineActive(const Session* session)
+{
+	return session->settings.playTimeline && keyCount(&session->timeline) > 0;
+}
+
+static void addTimelineKey(Timeline* timeline, const Gimbal* gimbal, float rotationDegPerSecond)
+{
+	// space the key by the time a concurrent rotation from the previous key takes
+	double keyTime = 0.0;
+	size_t keys = keyCount(timeline);
+	if ( keys > 0 )
+	{
+		float previous[3] = { timeline->x[keys - 1], timeline->y[keys - 1], timeline->z[keys - 1] };
+		Transition step;
+		makeTransition(&step, previous, gimbal->rotation, rotationDegPerSecond, ANIMATION_CONCURRENT, gimbal->eulerMode, EASING_LINEAR, nullptr);
+		double spacing = transitionDuration(&step);
+		keyTime = timelineDuration(timeline) + (std::isfinite(spacing) && spacing > MIN_KEY_SPACING ? spacing : MIN_KEY_SPACING);
+	}
+	addKey(timeline, keyTime, gimbal->rotation);
+}
+
+void applySession(Session* session, const SessionInput* input, Gimbal* gimbal, Gimbal* target)
+{
+	AnimationClock* clock = &session->clock;
+	Timeline* timeline = &session->timeline;
+
+	if ( input->stepRate != clock->stepRate )
+	{
+		// the clock counts steps, so keep it at the same time under the new rate
+		double time = clockTime(clock);
+		clock->stepRate = input->stepRate;
+		seekClock(clock, gimbal, time);
+	}
+	clock->easing = (EasingCurve)input->easing;
+	clock->bezier = &session->bezier;
+
+	// the curve is the session's own, so sessions applied side by side never share it
+	if ( setBezierEasing(&session->bezier, input->bezier) )
+	{
+		// poses baked with the old curve no longer match
+		clearBakeCache(&session->bakeCache);
+	}
+	if ( !input->bake && clock->bakeCache != nullptr )
+	{
+		clearBakeCache(&session->bakeCache);
+	}
+	clock->bakeCache = input->bake ? &session->bakeCache : nullptr;
+
+	timeline->interpolation = (KeyInterpolation)input->interpolation;
+	timeline->eulerMode = gimbal->eulerMode;
+	if ( input->actions & ACTION_CLEAR_KEYS )
+	{
+		clearTimeline(timeline);
+	}
+	if ( input->actions & ACTION_ADD_KEY )
+	{
+		addTimelineKey(timeline, gimbal, input->rotationDegPerSecond);
+	}
+	if ( input->actions & ACTION_WAYPOINT )
+	{
+		session->hasWaypoint = true;
+		memcpy(session->waypoint, input->waypoint, sizeof(Vec3));
+	}
+
+	session->settings = *input;
+	session->settings.actions = 0;
+	bool timelineActive = isTimelineActive(session);
+
+	if ( input->actions & ACTION_PLAY )
+	{
+		session->animate = true;
+		if ( timelineActive && clockTime(clock) >= timelineDuration(timeline) )
+		{
+			// replay a finished timeline from the start
+			seekTimeline(timeline, clock, gimbal, 0.0);
+		}
+	}
+	if ( input->actions & ACTION_STOP )
+	{
+		session->animate = false;
+		session->hasWaypoint = false;
+	}
+	else if ( !session->animate && !timelineActive && session->hasWaypoint )
+	{
+		// a waypoint that arrives at rest starts the primary towards it, as one arriving on the way does
+		memcpy(target->rotation, session->waypoint, sizeof(Vec3));
+		session->hasWaypoint = false;
+		session->animate = true;
+	}
+
+	if ( session->animate )
+	{
+		bool finished = timelineActive ?
+			advanceTimeline(timeline, clock, gimbal, input->deltaTime) :
+			advanceClock(clock, gimbal, target->rotation, input->rotationDegPerSecond, (AnimationMode)input->animationMode, input->deltaTime);
+		if ( finished )
+		{
+			// carry on to the next waypoint if one has arrived
+			if ( !timelineActive && session->hasWaypoint )
+			{
+				memcpy(target->rotation, session->waypoint, sizeof(Vec3));
+				session->hasWaypoint = false;
+			}
+			else
+			{
+				session->animate = false;
+			}
+		}
+	}
+
+	if ( input->actions & ACTION_SEEK )
+	{
+		if ( timelineActive )
+		{
+			seekTimeline(timeline, clock, gimbal, input->seekTime);
+		}
+		else
+		{
+			seekClock(clock, gimbal, input->seekTime);
+		}
+	}
+}
+
+//--------------------------------------------------------------------------------------------------
+// packing
+//--------------------------------------------------------------------------------------------------
+
+static uint32_t floatBits(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+static float bitsFloat(uint32_t bits)
+{
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static uint32_t gimbalFlags(const Gimbal* gimbal)
+{
+	return (gimbal->drawRotations ? 1u : 0u) | (gimbal->drawAxes ? 2u : 0u) |
+		((uint32_t)gimbal->eulerMode << 2) | ((uint32_t)gimbal->activeAxis << 5);
+}
+
+static void setGimbalFlags(Gimbal* gimbal, uint32_t flags)
+{
+	gimbal->drawRotations = (flags & 1u) != 0;
+	gimbal->drawAxes = (flags & 2u) != 0;
+	gimbal->eulerMode = (EulerMode)((flags >> 2) & 7u);
+	gimbal->activeAxis = (Axis)((flags >> 5) & 3u);
+}
+
+static void packFrame(const SessionInput* input, const Gimbal* gimbal, const Gimbal* target, const float result[3], uint32_t fields[FIELD_COUNT])
+{
+	fields[FIELD_DELTA_TIME] = floatBits(input->deltaTime);
+	for ( int ai = 0; ai < 3; ++ai )
+	{
+		fields[FIELD_PRIMARY_X + ai] = floatBits(gimbal->rotation[ai]);
+		fields[FIELD_TARGET_X + ai] = floatBits(target->rotation[ai]);
+		fields[FIELD_WAYPOINT_X + ai] = floatBits(input->waypoint[ai]);
+		fields[FIELD_RESULT_X + ai] = floatBits(result[ai]);
+	}
+	fields[FIELD_PRIMARY_ALPHA] = floatBits(gimbal->alpha);
+	fields[FIELD_PRIMARY_FLAGS] = gimbalFlags(gimbal);
+	fields[FIELD_TARGET_ALPHA] = floatBits(target->alpha);
+	fields[FIELD_TARGET_FLAGS] = gimbalFlags(target);
+	fields[FIELD_SPEED] = floatBits(input->rotationDegPerSecond);
+	fields[FIELD_STEP_RATE] = (uint32_t)input->stepRate;
+	fields[FIELD_MODE] = (uint32_t)input->animationMode;
+	fields[FIELD_EASING] = (uint32_t)input->easing;
+	for ( int ci = 0; ci < 4; ++ci )
+	{
+		fields[FIELD_BEZIER_X1 + ci] = floatBits(input->bezier[ci]);
+	}
+	fields[FIELD_OPTIONS] = (input->bake ? 1u : 0u) | (input->playTimeline ? 2u : 0u);
+	fields[FIELD_INTERPOLATION] = (uint32_t)input->interpolation;
+	fields[FIELD_ACTIONS] = input->actions;
+	fields[FIELD_SEEK_TIME] = floatBits(input->seekTime);
+}
+
+static void unpackFrame(const uint32_t fields[FIELD_COUNT], SessionInput* input, Gimbal* gimbal, Gimbal* target, float result[3])
+{
+	input->deltaTime = bitsFloat(fields[FIELD_DELTA_TIME]);
+	for ( int ai = 0; ai < 3; ++ai )
+	{
+		gimbal->rotation[ai] = bitsFloat(fields[FIELD_PRIMARY_X + ai]);
+		target->rotation[ai] = bitsFloat(fields[FIELD_TARGET_X + ai]);
+		input->waypoint[ai] = bitsFloat(fields[FIELD_WAYPOINT_X + ai]);
+		result[ai] = bitsFloat(fields[FIELD_RESULT_X + ai]);
+	}
+	gimbal->alpha = bitsFloat(fields[FIELD_PRIMARY_ALPHA]);
+	setGimbalFlags(gimbal, fields[FIELD_PRIMARY_FLAGS]);
+	target->alpha = bitsFloat(fields[FIELD_TARGET_ALPHA]);
+	setGimbalFlags(target, fields[FIELD_TARGET_FLAGS]);
+	input->rotationDegPerSecond = bitsFloat(fields[FIELD_SPEED]);
+	input->stepRate = (int)fields[FIELD_STEP_RATE];
+	input->animationMode = (int)fields[FIELD_MODE];
+	input->easing = (int)fields[FIELD_EASING];
+	for ( int ci = 0; ci < 4; ++ci )
+	{
+		input->bezier[ci] = bitsFloat(fields[FIELD_BEZIER_X1 + ci]);
+	}
+	input->bake = (fields[FIELD_OPTIONS] & 1u) != 0;
+	input->playTimeline = (fields[FIELD_OPTIONS] & 2u) != 0;
+	input->interpolation = (int)fields[FIELD_INTERPOLATION];
+	input->actions = fields[FIELD_ACTIONS];
+	input->seekTime = bitsFloat(fields[FIELD_SEEK_TIME]);
+}
+
+static void writeVarint(FILE* file, uint32_t value)
+{
+	// seven bits a byte, the top bit set on every byte but the last
+	while ( value >= 0x80u )
+	{
+		fputc((int)((value & 0x7fu) | 0x80u), file);
+		value >>= 7;
+	}
+	fputc((int)value, file);
+}
+
+static bool readVarint(FILE* file, uint32_t* value)
+{
+	*value = 0;
+	for ( int shift = 0; shift < 35; shift += 7 )
+	{
+		int byte = fgetc(file);
+		if ( byte == EOF )
+		{
+			return false;
+		}
+		*value |= (uint32_t)(byte & 0x7f) << shift;
+		if ( (byte & 0x80) == 0 )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+// recording
+//--------------------------------------------------------------------------------------------------
+
+bool beginRecording(SessionRecorder* recorder, const char* path)
+{
+	recorder->file = fopen(path, "wb");
+	if ( recorder->file == nullptr )
+	{
+		fprintf(stderr, "couldn't open '%s' to record the session\n", path);
+		return false;
+	}
+
+	fwrite(SESSION_MAGIC, 1, 4, recorder->file);
+	writeVarint(recorder->file, SESSION_VERSION);
+	memset(recorder->previous, 0, sizeof(recorder->previous));
+	recorder->frames = 0;
+	return true;
+}
+
+void recordFrame(SessionRecorder* recorder, const SessionInput* input, const Gimbal* gimbal, const Gimbal* target, const float result[3])
+{
+	if ( recorder->file == nullptr )
+	{
+		return;
+	}
+
+	uint32_t fields[FIELD_COUNT];
+	packFrame(input, gimbal, target, result, fields);
+
+	uint32_t changed = 0;
+	for ( int fi = 0; fi < FIELD_COUNT; ++fi )
+	{
+		changed |= fields[fi] != recorder->previous[fi] ? 1u << fi : 0u;
+	}
+
+	writeVarint(recorder->file, changed);
+	for ( int fi = 0; fi < FIELD_COUNT; ++fi )
+	{
+		if ( changed & (1u << fi) )
+		{
+			// nearby floats share their sign, exponent and top of the mantissa, which the xor clears
+			writeVarint(recorder->file, fields[fi] ^ recorder->previous[fi]);
+			recorder->previous[fi] = fields[fi];
+		}
+	}
+	++recorder->frames;
+}
+
+void endRecording(SessionRecorder* recorder)
+{
+	if ( recorder->file != nullptr )
+	{
+		fclose(recorder->file);
+		recorder->file = nullptr;
+	}
+}
+
+//--------------------------------------------------------------------------------------------------
+// replay
+//--------------------------------------------------------------------------------------------------
+
+bool openReplay(SessionPlayer* player, const char* path)
+{
+	player->file = fopen(path, "rb");
+	if ( player->file == nullptr )
+	{
+		fprintf(stderr, "couldn't open '%s' to replay\n", path);
+		return false;
+	}
+
+	char magic[4];
+	uint32_t version = 0;
+	if ( fread(magic, 1, 4, player->file) != 4 || memcmp(magic, SESSION_MAGIC, 4) != 0 ||
+		!readVarint(player->file, &version) || version != SESSION_VERSION )
+	{
+		fprintf(stderr, "'%s' isn't a session recording\n", path);
+		closeReplay(player);
+		return false;
+	}
+
+	memset(player->previous, 0, sizeof(player->previous));
+	player->frames = 0;
+	return true;
+}
+
+bool readFrame(SessionPlayer* player, SessionInput* input, Gimbal* gimbal, Gimbal* target, float result[3])
+{
+	uint32_t changed;
+	if ( player->file == nullptr || !readVarint(player->file, &changed) )
+	{
+		return false;
+	}
+
+	for ( int fi = 0; fi < FIELD_COUNT; ++fi )
+	{
+		uint32_t delta;
+		if ( (changed & (1u << fi)) != 0 )
+		{
+			if ( !readVarint(player->file, &delta) )
+			{
+				// a truncated frame, e.g. the recording was cut off mid-write
+				return false;
+			}
+			player->previous[fi] ^= delta;
+		}
+	}
+
+	unpackFrame(player->previous, input, gimbal, target, result);
+	++player->frames;
+	return true;
+}
+
+void closeReplay(SessionPlayer* player)
+{
+	if ( player->file != nullptr )
+	{
+		fclose(player->file);
+		player->file = nullptr;
+	}
+}
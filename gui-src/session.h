@@ -0,0 +1,80 @@
+#pragma once
+#include "animation.h"
+#include "bake.h"
+#include "timeline.h"
+#include <cstdint>
+#include <cstdio>
+
+enum SessionAction
+{
+	ACTION_PLAY = 1 << 0,
+	ACTION_STOP = 1 << 1,
+	ACTION_ADD_KEY = 1 << 2,
+	ACTION_CLEAR_KEYS = 1 << 3,
+	ACTION_SEEK = 1 << 4,     // jump to seekTime
+	ACTION_WAYPOINT = 1 << 5  // a waypoint arrived from the queue
+};
+
+// Everything the panel asks of the animation in one frame: the settings as they stand after the
+// widgets ran, and which buttons were pressed. The gimbals themselves are edited in place.
+struct SessionInput
+{
+	float deltaTime;
+	float rotationDegPerSecond;
+	int stepRate;
+	int animationMode;
+	int easing;
+	float bezier[4];
+	bool bake;
+	bool playTimeline;
+	int interpolation;
+	unsigned int actions;
+	float seekTime;
+	Vec3 waypoint;
+};
+
+// The animation state kept between frames. Applying the same inputs to the same gimbals always
+// gives the same poses, which is what lets a recorded session be replayed exactly.
+struct Session
+{
+	AnimationClock clock;
+	BezierEasing bezier; // the curve bezier easing follows, transitions point at it
+	BakeCache bakeCache;
+	Timeline timeline;
+	SessionInput settings; // the last inputs applied, actions cleared
+	bool animate;
+	bool hasWaypoint; // whether a waypoint is waiting to become the target
+	Vec3 waypoint;
+};
+
+void resetSession(Session* session);
+bool isTimelineActive(const Session* session);
+// applies one frame of input and advances the animation, live and in replay alike
+void applySession(Session* session, const SessionInput* input, Gimbal* gimbal, Gimbal* target);
+
+// Sessions are logged a frame at a time. Each frame is packed into fixed fields, and only the
+// fields that changed are written, as a varint of their bits xor'd with the previous frame's, so a
+// frame where only the delta time and a rotation move costs a handful of bytes.
+struct SessionRecorder
+{
+	FILE* file;
+	uint32_t previous[32];
+	long long frames;
+};
+
+struct SessionPlayer
+{
+	FILE* file;
+	uint32_t previous[32];
+	long long frames;
+};
+
+bool beginRecording(SessionRecorder* recorder, const char* path);
+// logs the input with the gimbals as they were before it was applied, and the primary's pose after
+void recordFrame(SessionRecorder* recorder, const SessionInput* input, const Gimbal* gimbal, const Gimbal* target, const float result[3]);
+void endRecording(SessionRecorder* recorder);
+
+bool openReplay(SessionPlayer* player, const char* path);
+// returns false at the end of the log
+bool readFrame(SessionPlayer* player, SessionInput* input, Gimbal* gimbal, Gimbal* target, float result[3]);
+void closeReplay(SessionPlayer* player);
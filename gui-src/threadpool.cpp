@@ -0,0 +1,157 @@
+#include "threadpool.h"
+
+static bool popTask(ThreadPool* pool, size_t self, RangeTask* task)
+{
+	size_t queueCount = pool->queues.size();
+
+	// own queue first, oldest task first
+	{
+		WorkQueue* own = pool->queues[self].get();
+		std::lock_guard<std::mutex> lock(own->mutex);
+		if ( !own->tasks.empty() )
+		{
+			*task = own->tasks.front();
+			own->tasks.pop_front();
+			pool->queued.fetch_sub(1);
+			return true;
+		}
+	}
+
+	// then steal the newest task from the others
+	for ( size_t qi = 1; qi < queueCount; ++qi )
+	{
+		WorkQueue* victim = pool->queues[(self + qi) % queueCount].get();
+		std::lock_guard<std::mutex> lock(victim->mutex);
+		if ( !victim->tasks.empty() )
+		{
+			*task = victim->tasks.back();
+			victim->tasks.pop_back();
+			pool->queued.fetch_sub(1);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void runTask(const RangeTask& task)
+{
+	(*task.func)(task.begin, task.end);
+	task.remaining->fetch_sub(1, std::memory_order_release);
+}
+
+static void workerLoop(ThreadPool* pool, size_t self)
+{
+	RangeTask task;
+	for ( ;; )
+	{
+		if ( popTask(pool, self, &task) )
+		{
+			runTask(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(pool->sleepMutex);
+		pool->wake.wait(lock, [pool] { return pool->stopping || pool->queued.load() > 0; });
+		if ( pool->stopping )
+		{
+			return;
+		}
+	}
+}
+
+void startThreadPool(ThreadPool* pool, size_t threadCount)
+{
+	if ( threadCount == 0 )
+	{
+		unsigned int hardware = std::thread::hardware_concurrency();
+		// the calling thread works too, so leave one core for it
+		threadCount = hardware > 1 ? hardware - 1 : 1;
+	}
+
+	pool->stopping = false;
+	pool->queued = 0;
+	pool->queues.clear();
+	for ( size_t qi = 0; qi < threadCount + 1; ++qi )
+	{
+		pool->queues.emplace_back(new WorkQueue());
+	}
+
+	// queue 0 belongs to the thread calling parallelFor
+	for ( size_t wi = 0; wi < threadCount; ++wi )
+	{
+		pool->workers.emplace_back(workerLoop, pool, wi + 1);
+	}
+}
+
+void stopThreadPool(ThreadPool* pool)
+{
+	{
+		std::lock_guard<std::mutex> lock(pool->sleepMutex);
+		pool->stopping = true;
+	}
+	pool->wake.notify_all();
+
+	for ( std::thread& worker : pool->workers )
+	{
+		worker.join();
+	}
+	pool->workers.clear();
+	pool->queues.clear();
+}
+
+size_t threadCount(const ThreadPool* pool)
+{
+	return pool->workers.size() + 1;
+}
+
+void parallelFor(ThreadPool* pool, size_t count, size_t chunkSize, const rangeFunc& func)
+{
+	if ( count == 0 )
+	{
+		return;
+	}
+
+	chunkSize = chunkSize > 0 ? chunkSize : 1;
+	size_t chunks = (count + chunkSize - 1) / chunkSize;
+	if ( chunks == 1 || pool->workers.empty() )
+	{
+		func(0, count);
+		return;
+	}
+
+	// deal the chunks out round-robin, neighbouring chunks go to different workers
+	std::atomic<size_t> remaining(chunks);
+	size_t queueCount = pool->queues.size();
+	for ( size_t qi = 0; qi < queueCount; ++qi )
+	{
+		WorkQueue* queue = pool->queues[qi].get();
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		for ( size_t ci = qi; ci < chunks; ci += queueCount )
+		{
+			size_t begin = ci * chunkSize;
+			size_t end = begin + chunkSize < count ? begin + chunkSize : count;
+			queue->tasks.push_back({ &func, begin, end, &remaining });
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(pool->sleepMutex);
+		pool->queued.fetch_add(chunks);
+	}
+	pool->wake.notify_all();
+
+	// help until every chunk has been taken, then wait for the ones still running
+	RangeTask task;
+	while ( remaining.load(std::memory_order_acquire) > 0 )
+	{
+		if ( popTask(pool, 0, &task) )
+		{
+			runTask(task);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
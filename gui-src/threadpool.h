@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// processes the items [begin, end)
+typedef std::function<void(size_t, size_t)> rangeFunc;
+
+struct RangeTask
+{
+	const rangeFunc* func;
+	size_t begin;
+	size_t end;
+	std::atomic<size_t>* remaining; // tasks of the same job still to finish
+};
+
+struct WorkQueue
+{
+	std::mutex mutex;
+	std::deque<RangeTask> tasks;
+};
+
+// A work-stealing pool with one worker per hardware thread. Each worker has its own queue: it takes
+// tasks from the front of its own and, once that runs dry, steals from the back of the others, so
+// uneven chunks even out without a shared queue becoming a bottleneck.
+struct ThreadPool
+{
+	std::vector<std::thread> workers;
+	std::vector<std::unique_ptr<WorkQueue>> queues; // one per worker, plus one for the caller
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	std::atomic<size_t> queued;
+	bool stopping;
+};
+
+// a thread count of 0 sizes the pool to the machine
+void startThreadPool(ThreadPool* pool, size_t threadCount);
+void stopThreadPool(ThreadPool* pool);
+size_t threadCount(const ThreadPool* pool);
+
+// splits [0, count) into chunks of at most chunkSize items and runs them across the pool, the
+// calling thread helps out and returns once every chunk has finished
+void parallelFor(ThreadPool* pool, size_t count, size_t chunkSize, const rangeFunc& func);
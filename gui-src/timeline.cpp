@@ -0,0 +1,347 @@
+#include "timeline.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// samples evaluated together by the spline kernels
+#define SAMPLE_BLOCK 64
+
+size_t keyCount(const Timeline* timeline)
+{
+	return timeline->times.size();
+}
+
+double timelineDuration(const Timeline* timeline)
+{
+	return timeline->times.empty() ? 0.0 : timeline->times.back();
+}
+
+void addKey(Timeline* timeline, double time, const float rotation[3])
+{
+	std::vector<double>& times = timeline->times;
+	size_t index = std::lower_bound(times.begin(), times.end(), time) - times.begin();
+	if ( index < times.size() && times[index] == time )
+	{
+		timeline->x[index] = rotation[AXIS_X];
+		timeline->y[index] = rotation[AXIS_Y];
+		timeline->z[index] = rotation[AXIS_Z];
+		timeline->spline.valid = false;
+		return;
+	}
+
+	times.insert(times.begin() + index, time);
+	timeline->x.insert(timeline->x.begin() + index, rotation[AXIS_X]);
+	timeline->y.insert(timeline->y.begin() + index, rotation[AXIS_Y]);
+	timeline->z.insert(timeline->z.begin() + index, rotation[AXIS_Z]);
+	timeline->cursor = 0;
+	timeline->spline.valid = false;
+}
+
+void clearTimeline(Timeline* timeline)
+{
+	timeline->times.clear();
+	timeline->x.clear();
+	timeline->y.clear();
+	timeline->z.clear();
+	timeline->cursor = 0;
+	timeline->spline.valid = false;
+}
+
+static size_t findSegment(Timeline* timeline, double time)
+{
+	const std::vector<double>& times = timeline->times;
+	size_t last = times.size() - 2;
+	size_t cursor = timeline->cursor <= last ? timeline->cursor : last;
+
+	// during playback the time is almost always in the same segment or the one after it
+	if ( times[cursor] <= time )
+	{
+		if ( time < times[cursor + 1] || cursor == last )
+		{
+			return cursor;
+		}
+		if ( time < times[cursor + 2] || cursor + 1 == last )
+		{
+			timeline->cursor = cursor + 1;
+			return cursor + 1;
+		}
+	}
+
+	// seek: find the last key at or before the time
+	size_t upper = std::upper_bound(times.begin(), times.end(), time) - times.begin();
+	cursor = upper == 0 ? 0 : upper - 1;
+	timeline->cursor = cursor <= last ? cursor : last;
+	return timeline->cursor;
+}
+
+static float keyTangent(const std::vector<float>& angles, const std::vector<double>& times, size_t key)
+{
+	// central difference over the neighbouring keys, one sided at the ends
+	size_t before = key > 0 ? key - 1 : key;
+	size_t after = key + 1 < times.size() ? key + 1 : key;
+	double span = times[after] - times[before];
+	if ( span <= 0.0 )
+	{
+		return 0.0f;
+	}
+	float travel = wrapAngle(angles[after] - angles[key]) + wrapAngle(angles[key] - angles[before]);
+	return (float)(travel / span);
+}
+
+static void buildSpline(Timeline* timeline)
+{
+	TimelineSpline& spline = timeline->spline;
+	size_t count = timeline->times.size();
+	spline.quats.resize(count);
+	spline.incoming.resize(count);
+	spline.outgoing.resize(count);
+	spline.tangentX.resize(count);
+	spline.tangentY.resize(count);
+	spline.tangentZ.resize(count);
+
+	for ( size_t ki = 0; ki < count; ++ki )
+	{
+		float rotation[3] = { timeline->x[ki], timeline->y[ki], timeline->z[ki] };
+		Quat q = eulerToQuat(rotation, timeline->eulerMode);
+		// q and -q are the same orientation, pick the one on the short arc from the previous key
+		if ( ki > 0 && quatDot(q, spline.quats[ki - 1]) < 0.0f )
+		{
+			q = { -q.w, -q.x, -q.y, -q.z };
+		}
+		spline.quats[ki] = q;
+
+		spline.tangentX[ki] = keyTangent(timeline->x, timeline->times, ki);
+		spline.tangentY[ki] = keyTangent(timeline->y, timeline->times, ki);
+		spline.tangentZ[ki] = keyTangent(timeline->z, timeline->times, ki);
+	}
+
+	// keys are spaced by how long the turn between them takes, so the control points allow for
+	// segments of different lengths
+	const std::vector<double>& times = timeline->times;
+	for ( size_t ki = 0; ki < count; ++ki )
+	{
+		spline.incoming[ki] = spline.quats[ki];
+		spline.outgoing[ki] = spline.quats[ki];
+		if ( ki > 0 && ki + 1 < count )
+		{
+			squadControls(spline.quats[ki - 1], spline.quats[ki], spline.quats[ki + 1],
+				(float)(times[ki] - times[ki - 1]), (float)(times[ki + 1] - times[ki]), &spline.incoming[ki], &spline.outgoing[ki]);
+		}
+	}
+
+	// the orientation along a segment is continuous, but which of its two angle sets is nearer a fixed
+	// reference can change under it, so references are chained along the segment from the angles of
+	// the key starting it, close enough together that the nearer set never flips between two of them
+	spline.anchorX.resize(count * SQUAD_ANCHORS);
+	spline.anchorY.resize(count * SQUAD_ANCHORS);
+	spline.anchorZ.resize(count * SQUAD_ANCHORS);
+	for ( size_t ki = 0; ki < count; ++ki )
+	{
+		size_t next = ki + 1 < count ? ki + 1 : ki;
+		float reference[3] = { timeline->x[ki], timeline->y[ki], timeline->z[ki] };
+		for ( size_t ai = 0; ai < SQUAD_ANCHORS; ++ai )
+		{
+			if ( ai > 0 )
+			{
+				Quat q = squadQuat(spline.quats[ki], spline.quats[next], spline.outgoing[ki], spline.incoming[next], (float)ai / SQUAD_ANCHORS);
+				float rotation[3];
+				quatToEuler(q, timeline->eulerMode, reference, rotation);
+				memcpy(reference, rotation, sizeof(Vec3));
+			}
+			spline.anchorX[ki * SQUAD_ANCHORS + ai] = reference[AXIS_X];
+			spline.anchorY[ki * SQUAD_ANCHORS + ai] = reference[AXIS_Y];
+			spline.anchorZ[ki * SQUAD_ANCHORS + ai] = reference[AXIS_Z];
+		}
+	}
+
+	spline.eulerMode = timeline->eulerMode;
+	spline.valid = true;
+}
+
+static void locateSample(Timeline* timeline, double time, size_t* key, float* t)
+{
+	if ( timeline->times.size() == 1 || time <= timeline->times.front() )
+	{
+		*key = 0;
+		*t = 0.0f;
+		return;
+	}
+
+	*key = findSegment(timeline, time);
+	double start = timeline->times[*key];
+	double end = timeline->times[*key + 1];
+	float progress = (float)((time - start) / (end - start));
+	*t = progress > 1.0f ? 1.0f : progress;
+}
+
+static void sampleCatmullRom(const Timeline* timeline, const size_t* keys, const float* t, size_t count, const std::vector<float>& angles, const std::vector<float>& tangents, float* out)
+{
+	float p0[SAMPLE_BLOCK], p1[SAMPLE_BLOCK], m0[SAMPLE_BLOCK], m1[SAMPLE_BLOCK];
+	size_t last = timeline->times.size() - 1;
+	for ( size_t li = 0; li < count; ++li )
+	{
+		// unwrap the next key against this one so the curve takes the shorter arc
+		size_t key = keys[li];
+		size_t next = key < last ? key + 1 : key;
+		float span = (float)(timeline->times[next] - timeline->times[key]);
+		p0[li] = angles[key];
+		p1[li] = angles[key] + wrapAngle(angles[next] - angles[key]);
+		m0[li] = tangents[key] * span;
+		m1[li] = tangents[next] * span;
+	}
+
+	hermiteColumns(count, p0, p1, m0, m1, t, out);
+	for ( size_t li = 0; li < count; ++li )
+	{
+		out[li] = wrapAngle(fmodf(out[li], 360.0f));
+	}
+}
+
+static void sampleSquad(const Timeline* timeline, const size_t* keys, const float* t, size_t count, float* x, float* y, float* z)
+{
+	float columns[16][SAMPLE_BLOCK];
+	float result[4][SAMPLE_BLOCK];
+	QuatColumns q0 = { columns[0], columns[1], columns[2], columns[3] };
+	QuatColumns q1 = { columns[4], columns[5], columns[6], columns[7] };
+	QuatColumns s0 = { columns[8], columns[9], columns[10], columns[11] };
+	QuatColumns s1 = { columns[12], columns[13], columns[14], columns[15] };
+	QuatColumns out = { result[0], result[1], result[2], result[3] };
+
+	const TimelineSpline& spline = timeline->spline;
+	size_t last = timeline->times.size() - 1;
+	for ( size_t li = 0; li < count; ++li )
+	{
+		size_t key = keys[li];
+		size_t next = key < last ? key + 1 : key;
+		const Quat* gather[4] = { &spline.quats[key], &spline.quats[next], &spline.outgoing[key], &spline.incoming[next] };
+		for ( int qi = 0; qi < 4; ++qi )
+		{
+			columns[qi * 4 + 0][li] = gather[qi]->w;
+			columns[qi * 4 + 1][li] = gather[qi]->x;
+			columns[qi * 4 + 2][li] = gather[qi]->y;
+			columns[qi * 4 + 3][li] = gather[qi]->z;
+		}
+	}
+
+	squadColumns(count, &q0, &q1, &s0, &s1, t, &out);
+
+	for ( size_t li = 0; li < count; ++li )
+	{
+		// the angle set nearest the segment's reference at or before the sample
+		size_t anchor = keys[li] * SQUAD_ANCHORS + std::min((size_t)(t[li] * SQUAD_ANCHORS), (size_t)SQUAD_ANCHORS - 1);
+		float reference[3] = { spline.anchorX[anchor], spline.anchorY[anchor], spline.anchorZ[anchor] };
+		Quat q = { result[0][li], result[1][li], result[2][li], result[3][li] };
+		float rotation[3];
+		quatToEuler(q, timeline->eulerMode, reference, rotation);
+		x[li] = rotation[AXIS_X];
+		y[li] = rotation[AXIS_Y];
+		z[li] = rotation[AXIS_Z];
+	}
+}
+
+void sampleTimelineBatch(Timeline* timeline, const double* times, size_t count, float* x, float* y, float* z)
+{
+	if ( timeline->times.empty() )
+	{
+		return;
+	}
+
+	KeyInterpolation interpolation = timeline->interpolation;
+	if ( interpolation != INTERPOLATE_LINEAR && (!timeline->spline.valid || timeline->spline.eulerMode != timeline->eulerMode) )
+	{
+		buildSpline(timeline);
+	}
+
+	size_t keys[SAMPLE_BLOCK];
+	float t[SAMPLE_BLOCK];
+	size_t last = timeline->times.size() - 1;
+	for ( size_t block = 0; block < count; block += SAMPLE_BLOCK )
+	{
+		size_t lanes = count - block < SAMPLE_BLOCK ? count - block : SAMPLE_BLOCK;
+		for ( size_t li = 0; li < lanes; ++li )
+		{
+			locateSample(timeline, times[block + li], &keys[li], &t[li]);
+		}
+
+		switch ( interpolation )
+		{
+		case INTERPOLATE_CATMULL_ROM:
+			sampleCatmullRom(timeline, keys, t, lanes, timeline->x, timeline->spline.tangentX, x + block);
+			sampleCatmullRom(timeline, keys, t, lanes, timeline->y, timeline->spline.tangentY, y + block);
+			sampleCatmullRom(timeline, keys, t, lanes, timeline->z, timeline->spline.tangentZ, z + block);
+			break;
+		case INTERPOLATE_SQUAD:
+			sampleSquad(timeline, keys, t, lanes, x + block, y + block, z + block);
+			break;
+		case INTERPOLATE_LINEAR:
+		default:
+			for ( size_t li = 0; li < lanes; ++li )
+			{
+				size_t key = keys[li];
+				size_t next = key < last ? key + 1 : key;
+				x[block + li] = lerpAngle(timeline->x[key], timeline->x[next], t[li]);
+				y[block + li] = lerpAngle(timeline->y[key], timeline->y[next], t[li]);
+				z[block + li] = lerpAngle(timeline->z[key], timeline->z[next], t[li]);
+			}
+			break;
+		}
+	}
+}
+
+void sampleTimeline(Timeline* timeline, double time, float rotation[3])
+{
+	sampleTimelineBatch(timeline, &time, 1, &rotation[AXIS_X], &rotation[AXIS_Y], &rotation[AXIS_Z]);
+}
+
+static void presentTimeline(Timeline* timeline, AnimationClock* clock, Gimbal* gimbal)
+{
+	// interpolate between the steps either side of the clock time, as for transitions
+	double dt = stepDuration(clock);
+	float current[3], next[3];
+	sampleTimeline(timeline, (double)clock->step * dt, current);
+	sampleTimeline(timeline, (double)(clock->step + 1) * dt, next);
+
+	float alpha = (float)(clock->accumulator / dt);
+	for ( int ai = 0; ai < 3; ++ai )
+	{
+		clock->presented[ai] = lerpAngle(current[ai], next[ai], alpha);
+		gimbal->rotation[ai] = clock->presented[ai];
+	}
+}
+
+bool advanceTimeline(Timeline* timeline, AnimationClock* clock, Gimbal* gimbal, float frameTime)
+{
+	if ( timeline->times.empty() )
+	{
+		return true;
+	}
+
+	// the clock no longer holds a transition, a transition played later starts afresh
+	clock->running = false;
+	tickClock(clock, frameTime);
+
+	double duration = timelineDuration(timeline);
+	if ( clockTime(clock) >= duration )
+	{
+		seekTimeline(timeline, clock, gimbal, duration);
+		return true;
+	}
+
+	presentTimeline(timeline, clock, gimbal);
+	return false;
+}
+
+void seekTimeline(Timeline* timeline, AnimationClock* clock, Gimbal* gimbal, double time)
+{
+	if ( timeline->times.empty() )
+	{
+		return;
+	}
+
+	double dt = stepDuration(clock);
+	double duration = timelineDuration(timeline);
+	time = time < 0.0 ? 0.0 : (time > duration ? duration : time);
+	clock->step = (long long)(time / dt);
+	clock->accumulator = time - (double)clock->step * dt;
+	presentTimeline(timeline, clock, gimbal);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "animation.h"
+#include "rotation.h"
+#include <vector>
+#include <cstddef>
+
+#define SQUAD_ANCHORS 32 // reference angle sets per SQUAD segment
+
+enum KeyInterpolation
+{
+	INTERPOLATE_LINEAR = 0,
+	INTERPOLATE_CATMULL_ROM = 1, // per axis cubic through the euler angles
+	INTERPOLATE_SQUAD = 2        // spherical cubic through the orientations
+};
+
+// Spline data derived from the keys, rebuilt on the next sample after any edit. Both splines are
+// C1 continuous at the keys, so playback doesn't jerk as it passes through them. A SQUAD sample's
+// angles depend only on its time, never on what was sampled before, so seeking shows the same
+// angles as playing through.
+struct TimelineSpline
+{
+	bool valid;
+	EulerMode eulerMode;        // mode the quaternions were built for
+	std::vector<Quat> quats;    // keys as quaternions, each in the hemisphere of the one before
+	std::vector<Quat> incoming; // SQUAD inner control points of the segment ending at each key
+	std::vector<Quat> outgoing; // and of the segment starting at it
+	std::vector<float> tangentX; // Catmull-Rom tangents in degrees per second
+	std::vector<float> tangentY;
+	std::vector<float> tangentZ;
+	std::vector<float> anchorX; // SQUAD_ANCHORS angle sets along each segment, chained from the angles
+	std::vector<float> anchorY; // of the key starting it, which pick the angle set a sample is given in
+	std::vector<float> anchorZ;
+};
+
+// Keyframed rotations for a single gimbal. Keys are kept sorted by time in separate contiguous
+// columns, so a lookup only walks the time column. Sampling remembers the segment it last used:
+// playing forwards finds the next segment in O(1) regardless of the number of keys, and any other
+// jump falls back to a binary search.
+struct Timeline
+{
+	std::vector<double> times;
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	size_t cursor; // index of the key starting the last sampled segment
+	KeyInterpolation interpolation;
+	EulerMode eulerMode; // mode the key angles are given in
+	TimelineSpline spline;
+};
+
+size_t keyCount(const Timeline* timeline);
+double timelineDuration(const Timeline* timeline);
+// inserts a key, replacing any key already at that time
+void addKey(Timeline* timeline, double time, const float rotation[3]);
+void clearTimeline(Timeline* timeline);
+void sampleTimeline(Timeline* timeline, double time, float rotation[3]);
+// samples many times at once, fastest when the times are in order; the splines are evaluated a
+// block of samples at a time with the column kernels from rotation.h
+void sampleTimelineBatch(Timeline* timeline, const double* times, size_t count, float* x, float* y, float* z);
+
+// plays the timeline on the clock and writes the pose to the gimbal, returns true at the end
+bool advanceTimeline(Timeline* timeline, AnimationClock* clock, Gimbal* gimbal, float frameTime);
+void seekTimeline(Timeline* timeline, AnimationClock* clock, Gimbal* gimbal, double time);
@@ -0,0 +1,143 @@
+#include "waypoints.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+// how long the feeder waits before trying a full queue again
+#define FEED_RETRY_MS 10
+
+bool pushWaypoint(WaypointQueue* queue, const float rotation[3])
+{
+	size_t tail = queue->tail.load(std::memory_order_relaxed);
+	size_t head = queue->head.load(std::memory_order_acquire);
+	if ( tail - head >= WAYPOINT_CAPACITY )
+	{
+		return false;
+	}
+
+	Waypoint& slot = queue->slots[tail & (WAYPOINT_CAPACITY - 1)];
+	slot.rotation[0] = rotation[0];
+	slot.rotation[1] = rotation[1];
+	slot.rotation[2] = rotation[2];
+	// publish the slot only once it is filled
+	queue->tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+bool popWaypoint(WaypointQueue* queue, float rotation[3])
+{
+	size_t head = queue->head.load(std::memory_order_relaxed);
+	size_t tail = queue->tail.load(std::memory_order_acquire);
+	if ( head == tail )
+	{
+		return false;
+	}
+
+	const Waypoint& slot = queue->slots[head & (WAYPOINT_CAPACITY - 1)];
+	rotation[0] = slot.rotation[0];
+	rotation[1] = slot.rotation[1];
+	rotation[2] = slot.rotation[2];
+	// hand the slot back only once it has been read
+	queue->head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+void clearWaypoints(WaypointQueue* queue)
+{
+	queue->head.store(queue->tail.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+size_t pendingWaypoints(const WaypointQueue* queue)
+{
+	size_t head = queue->head.load(std::memory_order_acquire);
+	size_t tail = queue->tail.load(std::memory_order_acquire);
+	return tail - head;
+}
+
+// the queue a line is meant for and its angles, or nullptr if the line isn't a waypoint
+static WaypointQueue* parseWaypoint(const WaypointFeeder* feeder, const char* line, float rotation[3])
+{
+	float values[4];
+	int fields = sscanf(line, "%f %f %f %f", &values[0], &values[1], &values[2], &values[3]);
+	if ( fields < 3 )
+	{
+		return nullptr;
+	}
+
+	WaypointQueue* queue = feeder->queue;
+	const float* angles = values;
+	if ( fields == 4 )
+	{
+		// the index must name one of the indexed queues exactly
+		if ( !(values[0] >= 0.0f) || values[0] != floorf(values[0]) || (size_t)values[0] >= feeder->indexedCount )
+		{
+			return nullptr;
+		}
+		queue = &feeder->indexed[(size_t)values[0]];
+		angles = values + 1;
+	}
+
+	for ( int ai = 0; ai < 3; ++ai )
+	{
+		if ( !std::isfinite(angles[ai]) )
+		{
+			return nullptr;
+		}
+		rotation[ai] = angles[ai];
+	}
+	return queue;
+}
+
+static void feedWaypoints(WaypointFeeder* feeder)
+{
+	char line[256];
+	while ( !feeder->stopping.load(std::memory_order_relaxed) && fgets(line, sizeof(line), feeder->file) != nullptr )
+	{
+		float rotation[3];
+		WaypointQueue* queue = parseWaypoint(feeder, line, rotation);
+		if ( queue == nullptr )
+		{
+			continue;
+		}
+		while ( !pushWaypoint(queue, rotation) )
+		{
+			if ( feeder->stopping.load(std::memory_order_relaxed) )
+			{
+				return;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(FEED_RETRY_MS));
+		}
+	}
+}
+
+bool startWaypointFeeder(WaypointFeeder* feeder, WaypointQueue* queue, WaypointQueue* indexed, size_t indexedCount, const char* path)
+{
+	feeder->file = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+	if ( feeder->file == nullptr )
+	{
+		return false;
+	}
+	feeder->queue = queue;
+	feeder->indexed = indexed;
+	feeder->indexedCount = indexed != nullptr ? indexedCount : 0;
+	feeder->stopping.store(false);
+	feeder->thread = std::thread(feedWaypoints, feeder);
+	return true;
+}
+
+void stopWaypointFeeder(WaypointFeeder* feeder)
+{
+	if ( !feeder->thread.joinable() )
+	{
+		return;
+	}
+	feeder->stopping.store(true);
+	if ( feeder->file == stdin )
+	{
+		feeder->thread.detach();
+		return;
+	}
+	feeder->thread.join();
+	fclose(feeder->file);
+	feeder->file = nullptr;
+}
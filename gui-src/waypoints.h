@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <thread>
+
+// must be a power of two
+#define WAYPOINT_CAPACITY 64
+
+struct Waypoint
+{
+	float rotation[3];
+};
+
+// A lock-free ring of pending targets for one gimbal, filled by a single producer thread (e.g. a
+// script or file loader) and drained by the animator. Each index is written by one side only, and
+// the two sit on separate cache lines so neither side's writes evict the other's.
+struct WaypointQueue
+{
+	alignas(64) std::atomic<size_t> head; // next slot to pop, written by the consumer
+	alignas(64) std::atomic<size_t> tail; // next slot to push, written by the producer
+	Waypoint slots[WAYPOINT_CAPACITY];
+};
+
+// producer side, returns false if the queue is full
+bool pushWaypoint(WaypointQueue* queue, const float rotation[3]);
+// consumer side, returns false if the queue is empty
+bool popWaypoint(WaypointQueue* queue, float rotation[3]);
+// consumer side, drops everything pending
+void clearWaypoints(WaypointQueue* queue);
+size_t pendingWaypoints(const WaypointQueue* queue);
+
+// Reads waypoints from a text file, or stdin for "-", and pushes them onto queues from a thread of
+// its own, so it is the one producer of every queue it is given. A line of three angles in degrees
+// goes to the main queue, and a line of an index and three angles to that entry of the further
+// queues, e.g. a scene's; other lines are skipped. A full queue makes it wait rather than drop any,
+// so a long file is fed in as the animator works through it.
+struct WaypointFeeder
+{
+	std::thread thread;
+	std::atomic<bool> stopping;
+	FILE* file;
+	WaypointQueue* queue;
+	WaypointQueue* indexed; // the queues indexed lines go to, if any
+	size_t indexedCount;
+};
+
+bool startWaypointFeeder(WaypointFeeder* feeder, WaypointQueue* queue, WaypointQueue* indexed, size_t indexedCount, const char* path);
+// a read from stdin can't be interrupted, so its thread is left to end with the process
+void stopWaypointFeeder(WaypointFeeder* feeder);
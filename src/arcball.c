@@ -0,0 +1,160 @@
+#include "arcball.h"
+#include <math.h>
+
+//--------------------------------------------------------------------------------------------------
+// defines
+//--------------------------------------------------------------------------------------------------
+
+#define PI 3.14159265358979323846f
+#define RAD_TO_DEG (180.0f / PI)
+
+// below this a point is too close to a constraint axis, or two points too near opposite, to say
+// which way to turn
+#define ARCBALL_EPSILON 1e-4f
+
+//--------------------------------------------------------------------------------------------------
+// prototypes
+//--------------------------------------------------------------------------------------------------
+
+static float dot( const float*, const float* );
+static void cross( const float*, const float*, float* );
+static bool normalise( float* );
+static bool ballPoint( const Arcball*, int, int, float* );
+
+//--------------------------------------------------------------------------------------------------
+// functions
+//--------------------------------------------------------------------------------------------------
+
+float dot( const float* a, const float* b )
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+void cross( const float* a, const float* b, float* result )
+{
+	result[0] = a[1] * b[2] - a[2] * b[1];
+	result[1] = a[2] * b[0] - a[0] * b[2];
+	result[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+bool normalise( float* v )
+{
+	float length = sqrtf( dot( v, v ) );
+	if ( length < ARCBALL_EPSILON )
+	{
+		return false;
+	}
+	v[0] /= length;
+	v[1] /= length;
+	v[2] /= length;
+	return true;
+}
+
+bool ballPoint( const Arcball* arcball, int x, int y, float* point )
+{
+	// on the front of the ball inside its outline, on its rim outside it
+	float px = ((float)x - arcball->centerX) / arcball->radius;
+	float py = (arcball->centerY - (float)y) / arcball->radius;
+	float squared = px * px + py * py;
+	float pz = 0.0f;
+	if ( squared > 1.0f )
+	{
+		float length = sqrtf( squared );
+		px /= length;
+		py /= length;
+	}
+	else
+	{
+		pz = sqrtf( 1.0f - squared );
+	}
+
+	for ( int i = 0; i < 3; ++i )
+	{
+		point[i] = arcball->right[i] * px + arcball->up[i] * py + arcball->back[i] * pz;
+	}
+
+	// a constrained drag follows the circle around the ring's axis
+	float along = dot( point, arcball->axis );
+	for ( int i = 0; i < 3; ++i )
+	{
+		point[i] -= arcball->axis[i] * along;
+	}
+	return normalise( point );
+}
+
+void beginArcball(Arcball* arcball, const Gimbal* gimbal, enum Axis constraint, const Camera* camera, int width, int height, int x, int y)
+{
+	width = width > 0 ? width : 1;
+	height = height > 0 ? height : 1;
+
+	// the same basis gluLookAt builds, with the ball centred on the point looked at
+	float forward[3];
+	for ( int i = 0; i < 3; ++i )
+	{
+		forward[i] = camera->lookat[i] - camera->position[i];
+	}
+	normalise( forward );
+	cross( forward, camera->up, arcball->right );
+	normalise( arcball->right );
+	cross( arcball->right, forward, arcball->up );
+	for ( int i = 0; i < 3; ++i )
+	{
+		arcball->back[i] = -forward[i];
+	}
+	arcball->centerX = 0.5f * (float)width;
+	arcball->centerY = 0.5f * (float)height;
+	arcball->radius = 0.5f * (float)(width < height ? width : height);
+
+	arcball->axis[0] = 0.0f;
+	arcball->axis[1] = 0.0f;
+	arcball->axis[2] = 0.0f;
+	arcball->constraint = constraint;
+	if ( constraint != AXIS_NONE )
+	{
+		eulerAxis( gimbal->rotation, gimbal->eulerMode, constraint, arcball->axis );
+	}
+	arcball->orientation = eulerToQuat( gimbal->rotation, gimbal->eulerMode );
+	for ( int i = 0; i < 3; ++i )
+	{
+		arcball->rotation[i] = gimbal->rotation[i];
+	}
+	arcball->active = ballPoint( arcball, x, y, arcball->start );
+}
+
+void dragArcball(const Arcball* arcball, Gimbal* gimbal, int x, int y)
+{
+	float point[3];
+	if ( !arcball->active || !ballPoint( arcball, x, y, point ) )
+	{
+		return;
+	}
+
+	if ( arcball->constraint != AXIS_NONE )
+	{
+		float turned[3];
+		cross( arcball->start, point, turned );
+		float degrees = atan2f( dot( turned, arcball->axis ), dot( arcball->start, point ) ) * RAD_TO_DEG;
+		float angle = fmodf( arcball->rotation[arcball->constraint] + degrees + 180.0f, 360.0f );
+		gimbal->rotation[arcball->constraint] = (angle < 0.0f ? angle + 360.0f : angle) - 180.0f;
+		return;
+	}
+
+	// the turn taking the start point to this one, from the half-way vector so the angle isn't doubled
+	float half[3] = { arcball->start[0] + point[0], arcball->start[1] + point[1], arcball->start[2] + point[2] };
+	if ( !normalise( half ) )
+	{
+		return;
+	}
+	float axis[3];
+	cross( arcball->start, half, axis );
+	Quat turn = { dot( arcball->start, half ), axis[0], axis[1], axis[2] };
+
+	// turned in world space, then split back into the angles closest to the current ones
+	Quat orientation = quatMultiply( turn, arcball->orientation );
+	quatToEuler( orientation, gimbal->eulerMode, gimbal->rotation, gimbal->rotation );
+}
+
+void endArcball(Arcball* arcball)
+{
+	arcball->active = false;
+}
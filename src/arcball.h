@@ -0,0 +1,40 @@
+#pragma once
+#include "rotation.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Turns a gimbal by dragging in the window as if rolling a ball under the cursor. The ball fills
+// the window around the camera's look-at point. Each drag is measured from where it began, so it
+// doesn't matter how many motion events arrive between frames. A free drag goes back into the
+// gimbal's euler angles through its own mode; a drag that starts on a ring turns only about that
+// ring's axis, which moves only that axis's angle, so it is added straight to it and can't be
+// thrown by gimbal lock.
+typedef struct Arcball
+{
+	bool active;
+	Vec3 start;       // where the drag began on the ball, in world space
+	Vec3 axis;        // the ring's axis in world space for a constrained drag, else zero
+	enum Axis constraint;
+	Quat orientation; // the gimbal's when the drag began
+	Vec3 rotation;
+
+	// the camera and window the drag is in
+	Vec3 right;
+	Vec3 up;
+	Vec3 back;
+	float centerX;
+	float centerY;
+	float radius;
+} Arcball;
+
+// starts a drag at a window pixel, y down as GLUT reports it; constraint is AXIS_NONE to turn freely
+void beginArcball(Arcball* arcball, const Gimbal* gimbal, enum Axis constraint, const Camera* camera, int width, int height, int x, int y);
+// sets the gimbal's rotation for the cursor at a pixel; does nothing if no drag is active
+void dragArcball(const Arcball* arcball, Gimbal* gimbal, int x, int y);
+void endArcball(Arcball* arcball);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,231 @@
+#include "extensions.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//--------------------------------------------------------------------------------------------------
+// entry points
+//--------------------------------------------------------------------------------------------------
+
+ActiveTextureFunc extActiveTexture = NULL;
+BlendFuncSeparateFunc extBlendFuncSeparate = NULL;
+
+GenBuffersFunc extGenBuffers = NULL;
+DeleteBuffersFunc extDeleteBuffers = NULL;
+BindBufferFunc extBindBuffer = NULL;
+BufferDataFunc extBufferData = NULL;
+BufferSubDataFunc extBufferSubData = NULL;
+
+CreateShaderFunc extCreateShader = NULL;
+ShaderSourceFunc extShaderSource = NULL;
+CompileShaderFunc extCompileShader = NULL;
+GetShaderivFunc extGetShaderiv = NULL;
+GetShaderInfoLogFunc extGetShaderInfoLog = NULL;
+DeleteShaderFunc extDeleteShader = NULL;
+CreateProgramFunc extCreateProgram = NULL;
+AttachShaderFunc extAttachShader = NULL;
+LinkProgramFunc extLinkProgram = NULL;
+GetProgramivFunc extGetProgramiv = NULL;
+GetProgramInfoLogFunc extGetProgramInfoLog = NULL;
+DeleteProgramFunc extDeleteProgram = NULL;
+UseProgramFunc extUseProgram = NULL;
+GetUniformLocationFunc extGetUniformLocation = NULL;
+Uniform1iFunc extUniform1i = NULL;
+DrawBuffersFunc extDrawBuffers = NULL;
+
+GenFramebuffersFunc extGenFramebuffers = NULL;
+DeleteFramebuffersFunc extDeleteFramebuffers = NULL;
+BindFramebufferFunc extBindFramebuffer = NULL;
+FramebufferTexture2DFunc extFramebufferTexture2D = NULL;
+CheckFramebufferStatusFunc extCheckFramebufferStatus = NULL;
+
+static bool buffersLoaded = false;
+static bool shadersLoaded = false;
+static bool framebuffersLoaded = false;
+static bool floatTexturesAvailable = false;
+static GLuint currentFramebuffer = 0;
+
+//--------------------------------------------------------------------------------------------------
+// prototypes
+//--------------------------------------------------------------------------------------------------
+
+// generic entry point type, casting from this to the real signature is well defined
+typedef void (*ProcFunc)(void);
+
+static ProcFunc getProc( const char*, const char* );
+static bool hasExtension( const char* );
+static int glMajorVersion( void );
+
+//--------------------------------------------------------------------------------------------------
+// functions
+//--------------------------------------------------------------------------------------------------
+
+ProcFunc getProc( const char* name, const char* fallback )
+{
+	GLUTproc proc = glutGetProcAddress( name );
+	if ( proc == NULL && fallback != NULL )
+	{
+		proc = glutGetProcAddress( fallback );
+	}
+	return (ProcFunc) proc;
+}
+
+bool hasExtension( const char* name )
+{
+	const char* extensions = (const char*) glGetString( GL_EXTENSIONS );
+	if ( extensions == NULL )
+	{
+		return false;
+	}
+
+	// match whole names only, some extension names are prefixes of others
+	size_t length = strlen( name );
+	const char* match = extensions;
+	while ( (match = strstr( match, name )) != NULL )
+	{
+		bool atStart = match == extensions || match[-1] == ' ';
+		bool atEnd = match[length] == ' ' || match[length] == '\0';
+		if ( atStart && atEnd )
+		{
+			return true;
+		}
+		match += length;
+	}
+	return false;
+}
+
+int glMajorVersion( void )
+{
+	const char* version = (const char*) glGetString( GL_VERSION );
+	return version ? atoi( version ) : 1;
+}
+
+void loadExtensions(void)
+{
+	extActiveTexture = (ActiveTextureFunc) getProc( "glActiveTexture", "glActiveTextureARB" );
+	extBlendFuncSeparate = (BlendFuncSeparateFunc) getProc( "glBlendFuncSeparate", "glBlendFuncSeparateEXT" );
+
+	extGenBuffers = (GenBuffersFunc) getProc( "glGenBuffers", "glGenBuffersARB" );
+	extDeleteBuffers = (DeleteBuffersFunc) getProc( "glDeleteBuffers", "glDeleteBuffersARB" );
+	extBindBuffer = (BindBufferFunc) getProc( "glBindBuffer", "glBindBufferARB" );
+	extBufferData = (BufferDataFunc) getProc( "glBufferData", "glBufferDataARB" );
+	extBufferSubData = (BufferSubDataFunc) getProc( "glBufferSubData", "glBufferSubDataARB" );
+
+	extCreateShader = (CreateShaderFunc) getProc( "glCreateShader", NULL );
+	extShaderSource = (ShaderSourceFunc) getProc( "glShaderSource", NULL );
+	extCompileShader = (CompileShaderFunc) getProc( "glCompileShader", NULL );
+	extGetShaderiv = (GetShaderivFunc) getProc( "glGetShaderiv", NULL );
+	extGetShaderInfoLog = (GetShaderInfoLogFunc) getProc( "glGetShaderInfoLog", NULL );
+	extDeleteShader = (DeleteShaderFunc) getProc( "glDeleteShader", NULL );
+	extCreateProgram = (CreateProgramFunc) getProc( "glCreateProgram", NULL );
+	extAttachShader = (AttachShaderFunc) getProc( "glAttachShader", NULL );
+	extLinkProgram = (LinkProgramFunc) getProc( "glLinkProgram", NULL );
+	extGetProgramiv = (GetProgramivFunc) getProc( "glGetProgramiv", NULL );
+	extGetProgramInfoLog = (GetProgramInfoLogFunc) getProc( "glGetProgramInfoLog", NULL );
+	extDeleteProgram = (DeleteProgramFunc) getProc( "glDeleteProgram", NULL );
+	extUseProgram = (UseProgramFunc) getProc( "glUseProgram", NULL );
+	extGetUniformLocation = (GetUniformLocationFunc) getProc( "glGetUniformLocation", NULL );
+	extUniform1i = (Uniform1iFunc) getProc( "glUniform1i", NULL );
+	extDrawBuffers = (DrawBuffersFunc) getProc( "glDrawBuffers", "glDrawBuffersARB" );
+
+	extGenFramebuffers = (GenFramebuffersFunc) getProc( "glGenFramebuffers", "glGenFramebuffersEXT" );
+	extDeleteFramebuffers = (DeleteFramebuffersFunc) getProc( "glDeleteFramebuffers", "glDeleteFramebuffersEXT" );
+	extBindFramebuffer = (BindFramebufferFunc) getProc( "glBindFramebuffer", "glBindFramebufferEXT" );
+	extFramebufferTexture2D = (FramebufferTexture2DFunc) getProc( "glFramebufferTexture2D", "glFramebufferTexture2DEXT" );
+	extCheckFramebufferStatus = (CheckFramebufferStatusFunc) getProc( "glCheckFramebufferStatus", "glCheckFramebufferStatusEXT" );
+
+	buffersLoaded = extGenBuffers && extDeleteBuffers && extBindBuffer && extBufferData && extBufferSubData;
+
+	shadersLoaded = extActiveTexture && extCreateShader && extShaderSource && extCompileShader &&
+		extGetShaderiv && extGetShaderInfoLog && extDeleteShader && extCreateProgram &&
+		extAttachShader && extLinkProgram && extGetProgramiv && extGetProgramInfoLog &&
+		extDeleteProgram && extUseProgram && extGetUniformLocation && extUniform1i && extDrawBuffers;
+
+	framebuffersLoaded = extGenFramebuffers && extDeleteFramebuffers && extBindFramebuffer &&
+		extFramebufferTexture2D && extCheckFramebufferStatus;
+
+	floatTexturesAvailable = glMajorVersion() >= 3 || hasExtension( "GL_ARB_texture_float" );
+}
+
+bool hasBuffers(void)
+{
+	return buffersLoaded;
+}
+
+bool hasShaders(void)
+{
+	return shadersLoaded;
+}
+
+bool hasFramebuffers(void)
+{
+	return framebuffersLoaded;
+}
+
+bool hasFloatTextures(void)
+{
+	return floatTexturesAvailable;
+}
+
+void bindFramebuffer(GLuint framebuffer)
+{
+	extBindFramebuffer( GL_FRAMEBUFFER, framebuffer );
+	currentFramebuffer = framebuffer;
+}
+
+GLuint boundFramebuffer(void)
+{
+	return currentFramebuffer;
+}
+
+void blendOver(void)
+{
+	if ( extBlendFuncSeparate != NULL )
+	{
+		extBlendFuncSeparate( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA );
+	}
+	else
+	{
+		glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+	}
+}
+
+GLuint createFragmentProgram(const char* fragmentSource)
+{
+	if ( !shadersLoaded )
+	{
+		return 0;
+	}
+
+	GLchar log[512];
+	GLint status = GL_FALSE;
+
+	GLuint shader = extCreateShader( GL_FRAGMENT_SHADER );
+	extShaderSource( shader, 1, &fragmentSource, NULL );
+	extCompileShader( shader );
+	extGetShaderiv( shader, GL_COMPILE_STATUS, &status );
+	if ( status != GL_TRUE )
+	{
+		extGetShaderInfoLog( shader, sizeof(log), NULL, log );
+		fprintf( stderr, "fragment shader failed to compile:\n%s\n", log );
+		extDeleteShader( shader );
+		return 0;
+	}
+
+	GLuint program = extCreateProgram();
+	extAttachShader( program, shader );
+	extLinkProgram( program );
+	// the program keeps the shader alive until it is deleted itself
+	extDeleteShader( shader );
+
+	extGetProgramiv( program, GL_LINK_STATUS, &status );
+	if ( status != GL_TRUE )
+	{
+		extGetProgramInfoLog( program, sizeof(log), NULL, log );
+		fprintf( stderr, "fragment program failed to link:\n%s\n", log );
+		extDeleteProgram( program );
+		return 0;
+	}
+
+	return program;
+}
@@ -0,0 +1,175 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <gl/freeglut.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The Windows OpenGL headers only cover GL 1.1, anything newer has to be loaded at runtime.
+// Entry points are prefixed with 'ext' so they never clash with prototypes from newer headers.
+
+#ifndef APIENTRY
+	#define APIENTRY
+#endif
+
+//--------------------------------------------------------------------------------------------------
+// types and enums
+//--------------------------------------------------------------------------------------------------
+
+#ifndef GL_VERSION_1_5
+typedef ptrdiff_t GLsizeiptr;
+typedef ptrdiff_t GLintptr;
+#endif
+#ifndef GL_VERSION_2_0
+typedef char GLchar;
+#endif
+
+#ifndef GL_TEXTURE0
+	#define GL_TEXTURE0 0x84C0
+#endif
+#ifndef GL_TEXTURE1
+	#define GL_TEXTURE1 0x84C1
+#endif
+#ifndef GL_ARRAY_BUFFER
+	#define GL_ARRAY_BUFFER 0x8892
+#endif
+#ifndef GL_ELEMENT_ARRAY_BUFFER
+	#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#endif
+#ifndef GL_STREAM_DRAW
+	#define GL_STREAM_DRAW 0x88E0
+#endif
+#ifndef GL_RGBA16F
+	#define GL_RGBA16F 0x881A
+#endif
+#ifndef GL_FRAGMENT_SHADER
+	#define GL_FRAGMENT_SHADER 0x8B30
+#endif
+#ifndef GL_COMPILE_STATUS
+	#define GL_COMPILE_STATUS 0x8B81
+#endif
+#ifndef GL_LINK_STATUS
+	#define GL_LINK_STATUS 0x8B82
+#endif
+#ifndef GL_FRAMEBUFFER
+	#define GL_FRAMEBUFFER 0x8D40
+#endif
+#ifndef GL_FRAMEBUFFER_COMPLETE
+	#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#endif
+#ifndef GL_COLOR_ATTACHMENT0
+	#define GL_COLOR_ATTACHMENT0 0x8CE0
+#endif
+#ifndef GL_COLOR_ATTACHMENT1
+	#define GL_COLOR_ATTACHMENT1 0x8CE1
+#endif
+#ifndef GL_DEPTH_ATTACHMENT
+	#define GL_DEPTH_ATTACHMENT 0x8D00
+#endif
+#ifndef GL_DEPTH_COMPONENT24
+	#define GL_DEPTH_COMPONENT24 0x81A6
+#endif
+
+//--------------------------------------------------------------------------------------------------
+// entry points
+//--------------------------------------------------------------------------------------------------
+
+// GL 1.3
+typedef void (APIENTRY *ActiveTextureFunc)(GLenum texture);
+
+// GL 1.4
+typedef void (APIENTRY *BlendFuncSeparateFunc)(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha);
+
+// GL 1.5 / ARB_vertex_buffer_object
+typedef void (APIENTRY *GenBuffersFunc)(GLsizei n, GLuint* buffers);
+typedef void (APIENTRY *DeleteBuffersFunc)(GLsizei n, const GLuint* buffers);
+typedef void (APIENTRY *BindBufferFunc)(GLenum target, GLuint buffer);
+typedef void (APIENTRY *BufferDataFunc)(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+typedef void (APIENTRY *BufferSubDataFunc)(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+
+// GL 2.0 shaders
+typedef GLuint (APIENTRY *CreateShaderFunc)(GLenum type);
+typedef void (APIENTRY *ShaderSourceFunc)(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length);
+typedef void (APIENTRY *CompileShaderFunc)(GLuint shader);
+typedef void (APIENTRY *GetShaderivFunc)(GLuint shader, GLenum pname, GLint* params);
+typedef void (APIENTRY *GetShaderInfoLogFunc)(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog);
+typedef void (APIENTRY *DeleteShaderFunc)(GLuint shader);
+typedef GLuint (APIENTRY *CreateProgramFunc)(void);
+typedef void (APIENTRY *AttachShaderFunc)(GLuint program, GLuint shader);
+typedef void (APIENTRY *LinkProgramFunc)(GLuint program);
+typedef void (APIENTRY *GetProgramivFunc)(GLuint program, GLenum pname, GLint* params);
+typedef void (APIENTRY *GetProgramInfoLogFunc)(GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog);
+typedef void (APIENTRY *DeleteProgramFunc)(GLuint program);
+typedef void (APIENTRY *UseProgramFunc)(GLuint program);
+typedef GLint (APIENTRY *GetUniformLocationFunc)(GLuint program, const GLchar* name);
+typedef void (APIENTRY *Uniform1iFunc)(GLint location, GLint v0);
+typedef void (APIENTRY *DrawBuffersFunc)(GLsizei n, const GLenum* bufs);
+
+// GL 3.0 / ARB_framebuffer_object / EXT_framebuffer_object
+typedef void (APIENTRY *GenFramebuffersFunc)(GLsizei n, GLuint* framebuffers);
+typedef void (APIENTRY *DeleteFramebuffersFunc)(GLsizei n, const GLuint* framebuffers);
+typedef void (APIENTRY *BindFramebufferFunc)(GLenum target, GLuint framebuffer);
+typedef void (APIENTRY *FramebufferTexture2DFunc)(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+typedef GLenum (APIENTRY *CheckFramebufferStatusFunc)(GLenum target);
+
+extern ActiveTextureFunc extActiveTexture;
+extern BlendFuncSeparateFunc extBlendFuncSeparate;
+
+extern GenBuffersFunc extGenBuffers;
+extern DeleteBuffersFunc extDeleteBuffers;
+extern BindBufferFunc extBindBuffer;
+extern BufferDataFunc extBufferData;
+extern BufferSubDataFunc extBufferSubData;
+
+extern CreateShaderFunc extCreateShader;
+extern ShaderSourceFunc extShaderSource;
+extern CompileShaderFunc extCompileShader;
+extern GetShaderivFunc extGetShaderiv;
+extern GetShaderInfoLogFunc extGetShaderInfoLog;
+extern DeleteShaderFunc extDeleteShader;
+extern CreateProgramFunc extCreateProgram;
+extern AttachShaderFunc extAttachShader;
+extern LinkProgramFunc extLinkProgram;
+extern GetProgramivFunc extGetProgramiv;
+extern GetProgramInfoLogFunc extGetProgramInfoLog;
+extern DeleteProgramFunc extDeleteProgram;
+extern UseProgramFunc extUseProgram;
+extern GetUniformLocationFunc extGetUniformLocation;
+extern Uniform1iFunc extUniform1i;
+extern DrawBuffersFunc extDrawBuffers;
+
+extern GenFramebuffersFunc extGenFramebuffers;
+extern DeleteFramebuffersFunc extDeleteFramebuffers;
+extern BindFramebufferFunc extBindFramebuffer;
+extern FramebufferTexture2DFunc extFramebufferTexture2D;
+extern CheckFramebufferStatusFunc extCheckFramebufferStatus;
+
+//--------------------------------------------------------------------------------------------------
+// functions
+//--------------------------------------------------------------------------------------------------
+
+// must be called once a GL context is current
+void loadExtensions(void);
+
+bool hasBuffers(void);
+bool hasShaders(void);
+bool hasFramebuffers(void);
+bool hasFloatTextures(void);
+
+// binds a framebuffer and remembers it, so a pass can restore whatever target it interrupted
+void bindFramebuffer(GLuint framebuffer);
+GLuint boundFramebuffer(void);
+
+// standard 'over' blending that also accumulates coverage in destination alpha when possible,
+// leaving off-screen targets premultiplied so they can be composited again later
+void blendOver(void);
+
+// compiles and links a program with only a fragment stage, vertices still go through the
+// fixed-function pipeline; returns 0 on failure
+GLuint createFragmentProgram(const char* fragmentSource);
+
+#ifdef __cplusplus
+}
+#endif
@@ -271,6 +271,58 @@ void drawGimbal(Gimbal* gimbal)
 	glPopMatrix();
 }
 
+bool isSameGimbalState(const Gimbal* a, const Gimbal* b)
+{
+	return a->rotation[0] == b->rotation[0] &&
+		a->rotation[1] == b->rotation[1] &&
+		a->rotation[2] == b->rotation[2] &&
+		a->alpha == b->alpha &&
+		a->drawRotations == b->drawRotations &&
+		a->drawAxes == b->drawAxes &&
+		a->eulerMode == b->eulerMode &&
+		a->activeAxis == b->activeAxis;
+}
+
+void drawGimbalCached(Gimbal* gimbal, GimbalDrawCache* cache)
+{
+	// replay the recorded commands if nothing that affects the geometry has changed
+	if ( cache->valid && isSameGimbalState( gimbal, &cache->state ) )
+	{
+		glCallList( cache->displayList );
+		return;
+	}
+
+	if ( cache->displayList == 0 )
+	{
+		cache->displayList = glGenLists( 1 );
+		if ( cache->displayList == 0 )
+		{
+			// out of display lists, fall back to immediate mode
+			drawGimbal( gimbal );
+			return;
+		}
+	}
+
+	// the state queries in the draw helpers run at record time, so the list is only valid
+	// while the lighting/normalisation state matches; display() sets this every frame
+	glNewList( cache->displayList, GL_COMPILE_AND_EXECUTE );
+	drawGimbal( gimbal );
+	glEndList();
+
+	cache->state = *gimbal;
+	cache->valid = true;
+}
+
+void releaseGimbalCache(GimbalDrawCache* cache)
+{
+	if ( cache->displayList != 0 )
+	{
+		glDeleteLists( cache->displayList, 1 );
+	}
+	cache->displayList = 0;
+	cache->valid = false;
+}
+
 void rotateEntity( Gimbal* gimbal, enum Axis axis )
 {
 	float rotaxis[3] = {0.0f, 0.0f, 0.0f};
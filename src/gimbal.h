@@ -41,7 +41,18 @@ typedef struct Gimbal
 	enum Axis activeAxis;
 } Gimbal;
 
+// recorded draw commands for a gimbal, replayed while the gimbal state is unchanged
+typedef struct GimbalDrawCache
+{
+	unsigned int displayList;
+	bool valid;
+	Gimbal state; // the gimbal state the display list was recorded with
+} GimbalDrawCache;
+
 void drawGimbal(Gimbal* gimbal);
+bool isSameGimbalState(const Gimbal* a, const Gimbal* b);
+void drawGimbalCached(Gimbal* gimbal, GimbalDrawCache* cache);
+void releaseGimbalCache(GimbalDrawCache* cache);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,235 @@
+#include "impostor.h"
+#include "extensions.h"
+#include "layers.h"
+#include <stdlib.h>
+
+//--------------------------------------------------------------------------------------------------
+// shaders
+//--------------------------------------------------------------------------------------------------
+
+static const char* compositeSource =
+	"#version 110\n"
+	"uniform sampler2D colorTexture;\n"
+	"void main()\n"
+	"{\n"
+	"	vec4 color = texture2D(colorTexture, gl_TexCoord[0].st);\n"
+	"	if (color.a <= 0.0)\n"
+	"	{\n"
+	"		discard;\n"
+	"	}\n"
+	"	gl_FragColor = color;\n"
+	"}\n";
+
+//--------------------------------------------------------------------------------------------------
+// state
+//--------------------------------------------------------------------------------------------------
+
+// the composite program is shared by every impostor
+static bool unsupported = false;
+static GLuint compositeProgram = 0;
+static GLuint previousFramebuffer = 0;
+
+//--------------------------------------------------------------------------------------------------
+// prototypes
+//--------------------------------------------------------------------------------------------------
+
+static bool isSameCamera( const Camera*, const Camera* );
+static bool createTargets( Impostor*, int, int );
+static void deleteTargets( Impostor* );
+
+//--------------------------------------------------------------------------------------------------
+// functions
+//--------------------------------------------------------------------------------------------------
+
+bool isSameCamera( const Camera* a, const Camera* b )
+{
+	for ( int i = 0; i < 3; ++i )
+	{
+		if ( a->position[i] != b->position[i] || a->lookat[i] != b->lookat[i] || a->up[i] != b->up[i] )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool createTargets( Impostor* impostor, int width, int height )
+{
+	glGenTextures( 1, &impostor->colorTexture );
+	glBindTexture( GL_TEXTURE_2D, impostor->colorTexture );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+	glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
+
+	glGenTextures( 1, &impostor->depthTexture );
+	glBindTexture( GL_TEXTURE_2D, impostor->depthTexture );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+	glTexImage2D( GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+
+	GLuint previous = boundFramebuffer();
+	extGenFramebuffers( 1, &impostor->framebuffer );
+	bindFramebuffer( impostor->framebuffer );
+	extFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, impostor->colorTexture, 0 );
+	extFramebufferTexture2D( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, impostor->depthTexture, 0 );
+	bool complete = extCheckFramebufferStatus( GL_FRAMEBUFFER ) == GL_FRAMEBUFFER_COMPLETE;
+	bindFramebuffer( previous );
+
+	impostor->width = width;
+	impostor->height = height;
+	return complete;
+}
+
+void deleteTargets( Impostor* impostor )
+{
+	if ( impostor->framebuffer != 0 )
+	{
+		extDeleteFramebuffers( 1, &impostor->framebuffer );
+	}
+	if ( impostor->colorTexture != 0 )
+	{
+		glDeleteTextures( 1, &impostor->colorTexture );
+	}
+	if ( impostor->depthTexture != 0 )
+	{
+		glDeleteTextures( 1, &impostor->depthTexture );
+	}
+
+	impostor->framebuffer = 0;
+	impostor->colorTexture = 0;
+	impostor->depthTexture = 0;
+	impostor->width = 0;
+	impostor->height = 0;
+	impostor->valid = false;
+}
+
+bool isImpostorValid(const Impostor* impostor, const Gimbal* gimbals, int count, const Camera* camera, int width, int height)
+{
+	if ( !impostor->valid || impostor->width != width || impostor->height != height || impostor->gimbalCount != count )
+	{
+		return false;
+	}
+
+	if ( !isSameCamera( &impostor->camera, camera ) )
+	{
+		return false;
+	}
+
+	for ( int i = 0; i < count; ++i )
+	{
+		if ( !isSameGimbalState( &impostor->gimbals[i], &gimbals[i] ) )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool beginImpostor(Impostor* impostor, int width, int height)
+{
+	if ( unsupported || width <= 0 || height <= 0 )
+	{
+		return false;
+	}
+
+	if ( compositeProgram == 0 )
+	{
+		// depth textures are core in GL 1.4, so framebuffers and shaders are all that's needed
+		compositeProgram = hasFramebuffers() ? createFragmentProgram( compositeSource ) : 0;
+		if ( compositeProgram == 0 )
+		{
+			unsupported = true;
+			return false;
+		}
+
+		extUseProgram( compositeProgram );
+		extUniform1i( extGetUniformLocation( compositeProgram, "colorTexture" ), 0 );
+		extUseProgram( 0 );
+	}
+
+	if ( impostor->width != width || impostor->height != height || impostor->framebuffer == 0 )
+	{
+		deleteTargets( impostor );
+		if ( !createTargets( impostor, width, height ) )
+		{
+			// incomplete framebuffers won't fix themselves, stop retrying every frame
+			deleteTargets( impostor );
+			unsupported = true;
+			return false;
+		}
+	}
+
+	previousFramebuffer = boundFramebuffer();
+	bindFramebuffer( impostor->framebuffer );
+
+	glPushAttrib( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+	glClearColor( 0.0f, 0.0f, 0.0f, 0.0f );
+	glClearDepth( 1.0 );
+	glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+	glPopAttrib();
+	return true;
+}
+
+void endImpostor(Impostor* impostor, const Gimbal* gimbals, int count, const Camera* camera)
+{
+	bindFramebuffer( previousFramebuffer );
+
+	if ( count > impostor->gimbalCapacity )
+	{
+		Gimbal* resized = realloc( impostor->gimbals, sizeof(Gimbal) * (size_t)count );
+		if ( resized == NULL )
+		{
+			// can't record the key, so never reuse this image
+			impostor->valid = false;
+			return;
+		}
+		impostor->gimbals = resized;
+		impostor->gimbalCapacity = count;
+	}
+
+	for ( int i = 0; i < count; ++i )
+	{
+		impostor->gimbals[i] = gimbals[i];
+	}
+	impostor->gimbalCount = count;
+	impostor->camera = *camera;
+	impostor->valid = true;
+}
+
+void drawImpostor(const Impostor* impostor)
+{
+	if ( !impostor->valid )
+	{
+		return;
+	}
+
+	// the image is a whole layer, so it goes over the layers beneath without a depth test; its depth
+	// can't be used anyway, the transparent pass writes none and leaves it at the far plane
+	glPushAttrib( GL_COLOR_BUFFER_BIT | GL_ENABLE_BIT );
+	glDisable( GL_LIGHTING );
+	glDisable( GL_CULL_FACE );
+	glDisable( GL_DEPTH_TEST );
+
+	// the colour is already premultiplied by its coverage
+	glEnable( GL_BLEND );
+	glBlendFunc( GL_ONE, GL_ONE_MINUS_SRC_ALPHA );
+
+	extUseProgram( compositeProgram );
+	glBindTexture( GL_TEXTURE_2D, impostor->colorTexture );
+
+	drawFullscreenQuad();
+
+	glBindTexture( GL_TEXTURE_2D, 0 );
+	extUseProgram( 0 );
+	glPopAttrib();
+}
+
+void releaseImpostor(Impostor* impostor)
+{
+	deleteTargets( impostor );
+	free( impostor->gimbals );
+	impostor->gimbals = NULL;
+	impostor->gimbalCount = 0;
+	impostor->gimbalCapacity = 0;
+}
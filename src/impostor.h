@@ -0,0 +1,40 @@
+#pragma once
+#include "gimbal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A cached image of a set of gimbals. While the gimbals, camera and viewport are unchanged the image
+// is composited back instead of drawing the geometry again. The colour is stored premultiplied and
+// drawn over whatever is already there, so the image should hold a whole overlay layer (see
+// layers.h); the depth buffer is only used while drawing into it.
+typedef struct Impostor
+{
+	unsigned int framebuffer;
+	unsigned int colorTexture;
+	unsigned int depthTexture;
+	int width;
+	int height;
+	bool valid;
+
+	// the state the image was rendered with
+	Camera camera;
+	Gimbal* gimbals;
+	int gimbalCount;
+	int gimbalCapacity;
+} Impostor;
+
+bool isImpostorValid(const Impostor* impostor, const Gimbal* gimbals, int count, const Camera* camera, int width, int height);
+
+// binds and clears the impostor as the render target; returns false if off-screen rendering is
+// unavailable, in which case the caller should draw the gimbals directly
+bool beginImpostor(Impostor* impostor, int width, int height);
+// restores the previous target and records the state the image was rendered with
+void endImpostor(Impostor* impostor, const Gimbal* gimbals, int count, const Camera* camera);
+void drawImpostor(const Impostor* impostor);
+void releaseImpostor(Impostor* impostor);
+
+#ifdef __cplusplus
+}
+#endif
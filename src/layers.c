@@ -0,0 +1,42 @@
+#include "layers.h"
+#include <gl/freeglut.h>
+
+void beginDepthLayer(int layer, int layerCount)
+{
+	if ( layerCount < 1 )
+	{
+		layerCount = 1;
+	}
+
+	// layer 0 gets the farthest slice, each later layer the slice in front of it
+	GLdouble sliceSize = 1.0 / (GLdouble)layerCount;
+	GLdouble farVal = 1.0 - sliceSize * (GLdouble)layer;
+	glDepthRange( farVal - sliceSize, farVal );
+}
+
+void endDepthLayers(void)
+{
+	glDepthRange( 0.0, 1.0 );
+}
+
+void drawFullscreenQuad(void)
+{
+	glMatrixMode( GL_PROJECTION );
+	glPushMatrix();
+	glLoadIdentity();
+	glMatrixMode( GL_MODELVIEW );
+	glPushMatrix();
+	glLoadIdentity();
+
+	glBegin( GL_QUADS );
+		glTexCoord2f( 0.0f, 0.0f ); glVertex2f( -1.0f, -1.0f );
+		glTexCoord2f( 1.0f, 0.0f ); glVertex2f(  1.0f, -1.0f );
+		glTexCoord2f( 1.0f, 1.0f ); glVertex2f(  1.0f,  1.0f );
+		glTexCoord2f( 0.0f, 1.0f ); glVertex2f( -1.0f,  1.0f );
+	glEnd();
+
+	glPopMatrix();
+	glMatrixMode( GL_PROJECTION );
+	glPopMatrix();
+	glMatrixMode( GL_MODELVIEW );
+}
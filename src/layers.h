@@ -0,0 +1,19 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Overlay layers partition the depth range into equal slices, with each layer's slice in front of
+// the layers before it. Geometry is still depth tested within its own layer but always draws over
+// earlier layers, so a single depth clear per frame is enough for any number of layers.
+void beginDepthLayer(int layer, int layerCount);
+void endDepthLayers(void);
+
+// draws a quad covering the viewport with texture coordinates in [0, 1], used to composite
+// off-screen layers back onto the current target
+void drawFullscreenQuad(void);
+
+#ifdef __cplusplus
+}
+#endif
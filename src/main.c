@@ -1,17 +1,92 @@
+#include "arcball.h"
+#include "extensions.h"
 #include "gimbal.h"
+#include "impostor.h"
+#include "layers.h"
+#include "picking.h"
+#include "posefile.h"
+#include "transparency.h"
 #include <gl/freeglut.h>
 
 #ifdef BUILD_GUI_EXT
 	#include <gui.h>
+	#include <profiler.h>
+	#include <math.h>
+	#include <stdio.h>
+	#include <stdlib.h>
+	#include <string.h>
+	#define PROFILE_BEGIN(phase) profiler_begin(phase)
+	#define PROFILE_END(phase) profiler_end(phase)
+	#define PROFILE_END_FRAME() profiler_end_frame()
+	#define PROFILE_TAKE_INPUT() profiler_take_input()
+	#define PROFILE_PRESENT() profiler_present()
+#else
+	#define PROFILE_BEGIN(phase)
+	#define PROFILE_END(phase)
+	#define PROFILE_END_FRAME()
+	#define PROFILE_TAKE_INPUT()
+	#define PROFILE_PRESENT()
 #endif
 
+// vertical field of view of the camera, in degrees
+#define CAMERA_FOV 38.0
+
+// overlay layers drawn on top of each other, see layers.h
+enum SceneLayer
+{
+	LAYER_PRIMARY,
+	LAYER_TARGET,
+	LAYER_COUNT
+};
+
 static Camera camera;
 static Gimbal primary;
 static Gimbal target;
+static GimbalDrawCache primaryCache;
+static GimbalDrawCache targetCache;
+static Impostor targetImpostor;
+// the gimbals that can be clicked in the viewport
+static PickScene pickScene;
+static Arcball arcball;
+
+#ifdef BUILD_GUI_EXT
+// spacing and size of the optional crowd of gimbals laid out on a grid below the primary
+#define CROWD_SPACING 0.6f
+#define CROWD_SCALE 0.2f
+#define CROWD_HEIGHT -1.5f
+
+// the crowd, listed in the gui's outliner where its rotations can be edited, and where the gui
+// rotates each of its gimbals to
+static Gimbal* crowd = NULL;
+static Gimbal* crowdTargets = NULL;
+static GimbalDrawCache* crowdCaches = NULL;
+static size_t crowdCount = 0;
+// the primary and then the crowd gathered into the one array a pick scene reads, copied in before
+// each pick, with where each is drawn and how big
+static Gimbal* pickGimbals = NULL;
+static Vec3* pickPositions = NULL;
+static float* pickScales = NULL;
+
+// the pose file --record-poses writes, with the primary and then the crowd as last written to it so
+// only the gimbals that moved are written again
+static PoseWriter poseWriter;
+static Gimbal* posesWritten = NULL;
+static int posesStartMs = 0;
+
+// radius and size of the ring of extra primary and target pairs around the primary
+#define PAIR_RADIUS 1.6f
+#define PAIR_SCALE 0.3f
+
+// the extra pairs, each animated by a controller of its own in the gui
+static Gimbal* pairGimbals = NULL;
+static Gimbal* pairTargets = NULL;
+static GimbalDrawCache* pairCaches = NULL; // two per pair, the gimbal's then the target's
+static size_t pairCount = 0;
+#endif
 
 void setCamera(int width, int height)
 {
-	GLdouble fov     = 38.0;    // degrees
+	GLdouble fov     = CAMERA_FOV;
 	GLdouble aspect  = 1.0 * ((GLdouble) width / (GLdouble) height);     // aspect ratio aspect = height/width
 	GLdouble nearVal = 0.5;
 	GLdouble farVal  = 500.0;
@@ -62,6 +137,22 @@ void setLight(void)
 	glMaterialfv(GL_FRONT, GL_SHININESS, material_shininess);
 }
 
+// The state the scene is drawn with, set in full every frame rather than once in init(): the gui
+// pass sets its own state and leaves it behind instead of reading ours back and restoring it, see
+// gui_set_known_state. The lighting state is set alongside the lights in setLight().
+void setSceneState(void)
+{
+	glDisable(GL_BLEND);
+	glDisable(GL_SCISSOR_TEST);
+	glDisable(GL_TEXTURE_2D);
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_CULL_FACE);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+}
+
 void init(void)
 {
 	glClearColor(1.0, 1.0, 1.0, 1.0);
@@ -74,6 +165,9 @@ void init(void)
 	glEnable( GL_CULL_FACE );
 	glCullFace( GL_BACK );
 
+	// load the entry points used by the off-screen passes
+	loadExtensions();
+
 	// Setting the camera extrinsic parameter (position, lookat and up vector)
 	camera.position[0] = 2.5f;
 	camera.position[1] = 2.5f;
@@ -116,17 +210,276 @@ void init(void)
 	target.eulerMode = EULER_MODE_XYZ;
 	target.activeAxis = AXIS_NONE;
 	target.alpha = 0.3f;
+
+	// only the primary can be clicked, the target is a preview of where it is going; a crowd joins
+	// it in initCrowd
+	buildPickScene(&pickScene, &primary, NULL, NULL, 1);
+}
+
+#ifdef BUILD_GUI_EXT
+// writes the primary, as gimbal 0, and the crowd, from 1, to the pose file wherever they changed
+// since they were last written, timed from when recording began
+void recordPoses(void)
+{
+	double time = (double)(glutGet(GLUT_ELAPSED_TIME) - posesStartMs) / 1000.0;
+	for (size_t gi = 0; gi <= crowdCount; ++gi)
+	{
+		const Gimbal* gimbal = gi == 0 ? &primary : &crowd[gi - 1];
+		Gimbal* written = &posesWritten[gi];
+		if (memcmp(gimbal->rotation, written->rotation, sizeof(Vec3)) == 0 && gimbal->eulerMode == written->eulerMode)
+		{
+			continue;
+		}
+		writePose(&poseWriter, time, (uint32_t)gi, gimbal->rotation, gimbal->eulerMode);
+		*written = *gimbal;
+	}
+}
+
+// where a gimbal of the crowd stands, on a square grid centred under the primary
+void crowdPosition(size_t index, float position[3])
+{
+	size_t side = 1;
+	while (side * side < crowdCount)
+	{
+		++side;
+	}
+
+	float offset = 0.5f * (float)(side - 1) * CROWD_SPACING;
+	position[0] = (float)(index % side) * CROWD_SPACING - offset;
+	position[1] = CROWD_HEIGHT;
+	position[2] = (float)(index / side) * CROWD_SPACING - offset;
+}
+
+// a crowd of gimbals in every euler mode with scattered rotations and targets, the same on every run
+bool initCrowd(size_t count)
+{
+	crowd = (Gimbal*)calloc(count, sizeof(Gimbal));
+	crowdTargets = (Gimbal*)calloc(count, sizeof(Gimbal));
+	crowdCaches = (GimbalDrawCache*)calloc(count, sizeof(GimbalDrawCache));
+	if (crowd == NULL || crowdTargets == NULL || crowdCaches == NULL)
+	{
+		free(crowd);
+		free(crowdTargets);
+		free(crowdCaches);
+		crowd = NULL;
+		crowdTargets = NULL;
+		crowdCaches = NULL;
+		return false;
+	}
+
+	srand(1);
+	for (size_t gi = 0; gi < count; ++gi)
+	{
+		for (int ai = 0; ai < 3; ++ai)
+		{
+			crowd[gi].rotation[ai] = (float)(rand() % 360 - 180);
+		}
+		crowd[gi].alpha = 1.0f;
+		crowd[gi].drawAxes = false;
+		crowd[gi].drawRotations = true;
+		crowd[gi].eulerMode = (enum EulerMode)(gi % (EULER_MODE_ZYX + 1));
+		crowd[gi].activeAxis = AXIS_NONE;
+
+		crowdTargets[gi] = crowd[gi];
+		for (int ai = 0; ai < 3; ++ai)
+		{
+			crowdTargets[gi].rotation[ai] = (float)(rand() % 360 - 180);
+		}
+	}
+	crowdCount = count;
+
+	// the crowd can be clicked as well as the primary, which keeps index 0 of the pick scene; if
+	// there is no room for the larger scene only the primary stays pickable
+	pickGimbals = (Gimbal*)calloc(count + 1, sizeof(Gimbal));
+	pickPositions = (Vec3*)calloc(count + 1, sizeof(Vec3));
+	pickScales = (float*)calloc(count + 1, sizeof(float));
+	if (pickGimbals != NULL && pickPositions != NULL && pickScales != NULL)
+	{
+		pickGimbals[0] = primary;
+		pickScales[0] = 1.0f;
+		for (size_t gi = 0; gi < count; ++gi)
+		{
+			pickGimbals[gi + 1] = crowd[gi];
+			crowdPosition(gi, pickPositions[gi + 1]);
+			pickScales[gi + 1] = CROWD_SCALE;
+		}
+		releasePickScene(&pickScene);
+		if (buildPickScene(&pickScene, pickGimbals, (const Vec3*)pickPositions, pickScales, count + 1))
+		{
+			return true;
+		}
+		buildPickScene(&pickScene, &primary, NULL, NULL, 1);
+	}
+	free(pickGimbals);
+	free(pickPositions);
+	free(pickScales);
+	pickGimbals = NULL;
+	pickPositions = NULL;
+	pickScales = NULL;
+	return true;
+}
+
+void drawCrowd(void)
+{
+	for (size_t gi = 0; gi < crowdCount; ++gi)
+	{
+		Vec3 position;
+		crowdPosition(gi, position);
+		glPushMatrix();
+		glTranslatef(position[0], position[1], position[2]);
+		glScalef(CROWD_SCALE, CROWD_SCALE, CROWD_SCALE);
+		drawGimbalCached(&crowd[gi], &crowdCaches[gi]);
+		glPopMatrix();
+	}
+}
+
+// pairs with scattered targets the same on every run, each a small copy of the primary and target
+bool initPairs(size_t count)
+{
+	pairGimbals = (Gimbal*)calloc(count, sizeof(Gimbal));
+	pairTargets = (Gimbal*)calloc(count, sizeof(Gimbal));
+	pairCaches = (GimbalDrawCache*)calloc(2 * count, sizeof(GimbalDrawCache));
+	if (pairGimbals == NULL || pairTargets == NULL || pairCaches == NULL)
+	{
+		free(pairGimbals);
+		free(pairTargets);
+		free(pairCaches);
+		pairGimbals = NULL;
+		pairTargets = NULL;
+		pairCaches = NULL;
+		return false;
+	}
+
+	srand(2);
+	for (size_t pi = 0; pi < count; ++pi)
+	{
+		pairGimbals[pi] = primary;
+		pairTargets[pi] = target;
+		for (int ai = 0; ai < 3; ++ai)
+		{
+			pairTargets[pi].rotation[ai] = (float)(rand() % 360 - 180);
+		}
+	}
+	pairCount = count;
+	return true;
+}
+
+// the pairs' gimbals, or their targets, each at its place on the ring
+void drawPairs(bool targets)
+{
+	for (size_t pi = 0; pi < pairCount; ++pi)
+	{
+		float angle = 6.2831853f * (float)pi / (float)pairCount;
+		glPushMatrix();
+		glTranslatef(PAIR_RADIUS * cosf(angle), 0.0f, PAIR_RADIUS * sinf(angle));
+		glScalef(PAIR_SCALE, PAIR_SCALE, PAIR_SCALE);
+		if (targets)
+		{
+			drawGimbalCached(&pairTargets[pi], &pairCaches[2 * pi + 1]);
+		}
+		else
+		{
+			drawGimbalCached(&pairGimbals[pi], &pairCaches[2 * pi]);
+		}
+		glPopMatrix();
+	}
+}
+#endif
+
+void drawTargetLayer(int width, int height)
+{
+	// translucent gimbals are resolved without sorting when the driver supports it
+	if (beginTransparentPass(width, height))
+	{
+		drawGimbalCached(&target, &targetCache);
+		endTransparentPass();
+	}
+	else
+	{
+		// enable blending to render the target gimbal transparently
+		glEnable(GL_BLEND);
+		blendOver();
+		// draw the target gimbal
+		drawGimbalCached(&target, &targetCache);
+		glDisable(GL_BLEND);
+	}
+}
+
+// the nearest ring or arrow under a window pixel; gimbal 0 is the primary, and any crowd follows
+bool pickAt(int x, int y, PickHit* hit)
+{
+#ifdef BUILD_GUI_EXT
+	if (pickGimbals != NULL)
+	{
+		pickGimbals[0] = primary;
+		memcpy(&pickGimbals[1], crowd, crowdCount * sizeof(Gimbal));
+	}
+#endif
+	refitPickScene(&pickScene);
+	Ray ray = cameraRay(&camera, (float)CAMERA_FOV, glutGet(GLUT_WINDOW_WIDTH), glutGet(GLUT_WINDOW_HEIGHT), x, y);
+	return pickRay(&pickScene, &ray, hit);
+}
+
+// the axis of the primary's ring under a window pixel, or AXIS_NONE for its arrow or nothing
+enum Axis pickAxis(int x, int y)
+{
+	PickHit hit;
+	return pickAt(x, y, &hit) && hit.gimbal == 0 ? hit.axis : AXIS_NONE;
 }
 
 void display(void)
 {
+	PROFILE_BEGIN(PROFILE_FRAME);
+	// the input stamped since the last frame is shown by this one
+	PROFILE_TAKE_INPUT();
 #ifdef BUILD_GUI_EXT
 	// call reshape every frame to ensure the window is always the correct size
 	reshape(glutGet(GLUT_WINDOW_WIDTH), glutGet(GLUT_WINDOW_HEIGHT));
 
+	// a click the gui didn't take selects the ring under it, and dragging from there turns the
+	// primary about that ring, or freely when it started off the rings; a click on one of the crowd
+	// selects it in the outliner instead. The latest cursor position is applied before the gui frame
+	// so this frame already shows it
+	int clickX;
+	int clickY;
+	if (gui_take_click(&clickX, &clickY))
+	{
+		PickHit hit;
+		bool picked = pickAt(clickX, clickY, &hit);
+		if (picked && hit.gimbal > 0)
+		{
+			gui_select_gimbal(hit.gimbal - 1);
+			gui_select_axis(AXIS_NONE);
+		}
+		else
+		{
+			enum Axis axis = picked ? hit.axis : AXIS_NONE;
+			gui_select_axis(axis);
+			beginArcball(&arcball, &primary, axis, &camera, glutGet(GLUT_WINDOW_WIDTH), glutGet(GLUT_WINDOW_HEIGHT), clickX, clickY);
+		}
+	}
+	int dragX;
+	int dragY;
+	if (gui_viewport_drag(&dragX, &dragY))
+	{
+		dragArcball(&arcball, &primary, dragX, dragY);
+	}
+	else
+	{
+		endArcball(&arcball);
+	}
+
+	PROFILE_BEGIN(PROFILE_GUI_UPDATE);
 	gui_update(&primary, &target);
+	PROFILE_END(PROFILE_GUI_UPDATE);
+	if (posesWritten != NULL)
+	{
+		recordPoses();
+	}
 #endif
 
+	// before the clear, which a scissor left on would clip
+	setSceneState();
 
 	// clear buffers
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -146,25 +499,84 @@ void display(void)
 	);
 
 	// draw gimbal and flush
-	drawGimbal(&primary);
-
-	// clear the depth buffer to render the target gimbal
-	glClear(GL_DEPTH_BUFFER_BIT);
-	// enable blending to render the target gimbal transparently
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	// draw the target gimbal
-	drawGimbal(&target);
-	glDisable(GL_BLEND);
+	PROFILE_BEGIN(PROFILE_DRAW_GIMBALS);
+	beginDepthLayer(LAYER_PRIMARY, LAYER_COUNT);
+	drawGimbalCached(&primary, &primaryCache);
+#ifdef BUILD_GUI_EXT
+	drawCrowd();
+	drawPairs(false);
+#endif
+
+	// the target is drawn in the layer above so it is never hidden by the primary
+	beginDepthLayer(LAYER_TARGET, LAYER_COUNT);
+	// the target rarely moves, so it is drawn once into a cached image and composited back in
+	// until its state, the camera or the window size changes
+	int width = glutGet(GLUT_WINDOW_WIDTH);
+	int height = glutGet(GLUT_WINDOW_HEIGHT);
+	if (isImpostorValid(&targetImpostor, &target, 1, &camera, width, height))
+	{
+		drawImpostor(&targetImpostor);
+	}
+	else if (beginImpostor(&targetImpostor, width, height))
+	{
+		drawTargetLayer(width, height);
+		endImpostor(&targetImpostor, &target, 1, &camera);
+		drawImpostor(&targetImpostor);
+	}
+	else
+	{
+		drawTargetLayer(width, height);
+	}
+#ifdef BUILD_GUI_EXT
+	// the pairs' targets can be retargeted from the panel, so they are drawn outside the impostor
+	if (pairCount > 0)
+	{
+		glEnable(GL_BLEND);
+		blendOver();
+		drawPairs(true);
+		glDisable(GL_BLEND);
+	}
+#endif
+	endDepthLayers();
+	PROFILE_END(PROFILE_DRAW_GIMBALS);
 
 #ifdef BUILD_GUI_EXT
+	PROFILE_BEGIN(PROFILE_GUI_RENDER);
 	gui_render();
+	PROFILE_END(PROFILE_GUI_RENDER);
 #endif
 
 	glFlush();
+	PROFILE_PRESENT();
+	PROFILE_END(PROFILE_FRAME);
+	PROFILE_END_FRAME();
 }
 
 #ifndef BUILD_GUI_EXT
+void mouse(int button, int state, int x, int y)
+{
+	if (button != GLUT_LEFT_BUTTON)
+	{
+		return;
+	}
+	if (state == GLUT_DOWN)
+	{
+		primary.activeAxis = pickAxis(x, y);
+		beginArcball(&arcball, &primary, primary.activeAxis, &camera, glutGet(GLUT_WINDOW_WIDTH), glutGet(GLUT_WINDOW_HEIGHT), x, y);
+	}
+	else
+	{
+		endArcball(&arcball);
+	}
+	glutPostRedisplay();
+}
+
+void motion(int x, int y)
+{
+	dragArcball(&arcball, &primary, x, y);
+	glutPostRedisplay();
+}
+
 void keys(unsigned char key, int x, int y)
 {
 	// 'use' the parameters to avoid warnings
@@ -282,13 +694,79 @@ void keysUp(unsigned char key, int x, int y)
 }
 #endif
 
+#ifdef BUILD_GUI_EXT
+// how often a resting gui is checked for work that doesn't come from input, e.g. queued waypoints
+#define IDLE_POLL_MS 50
+
+void idleFunc( void );
+
+void wakeFunc( int value )
+{
+	(void)value;
+	glutIdleFunc(idleFunc);
+}
+#endif
+
+// releases the GL objects the scene holds, while the context they belong to still exists
+void closeFunc( void )
+{
+	releaseGimbalCache(&primaryCache);
+	releaseGimbalCache(&targetCache);
+	releaseTransparentPass();
+	releaseImpostor(&targetImpostor);
+#ifdef BUILD_GUI_EXT
+	for (size_t gi = 0; gi < crowdCount; ++gi)
+	{
+		releaseGimbalCache(&crowdCaches[gi]);
+	}
+	for (size_t ci = 0; ci < 2 * pairCount; ++ci)
+	{
+		releaseGimbalCache(&pairCaches[ci]);
+	}
+#endif
+}
+
 void idleFunc( void )
 {
+#ifdef BUILD_GUI_EXT
+	// nothing on screen is changing, so stop redrawing and only look again every so often;
+	// input events still redraw straight away
+	if (!gui_wants_update())
+	{
+		glutIdleFunc(NULL);
+		glutTimerFunc(IDLE_POLL_MS, wakeFunc, 0);
+		return;
+	}
+#endif
 	glutPostRedisplay();
 }
 
+#ifdef BUILD_GUI_EXT
+// the value following an option anywhere on the command line, or NULL when it isn't given
+const char* optionValue(int argc, char** argv, const char* name)
+{
+	for (int ai = 1; ai + 1 < argc; ++ai)
+	{
+		if (strcmp(argv[ai], name) == 0)
+		{
+			return argv[ai + 1];
+		}
+	}
+	return NULL;
+}
+#endif
+
 int main(int argc, char** argv)
 {
+#ifdef BUILD_GUI_EXT
+	// --replay <file> [repeat] replays the panel input of a recorded session headless and exits; the
+	// outliner, scene and other pairs aren't recorded, so only the primary pair is replayed
+	if (argc >= 3 && strcmp(argv[1], "--replay") == 0)
+	{
+		return gui_replay(argv[2], argc >= 4 ? atoi(argv[3]) : 1) ? 0 : 1;
+	}
+#endif
+
 	// GLUT initialization
 	glutInit(&argc,argv);
 #ifdef __FREEGLUT_EXT_H__
@@ -304,21 +782,118 @@ int main(int argc, char** argv)
 	// GLUT callbacks
 	glutDisplayFunc(display);
 	glutIdleFunc(idleFunc);
+#ifdef __FREEGLUT_EXT_H__
+	glutCloseFunc(closeFunc);
+#endif
 #ifndef BUILD_GUI_EXT
 	glutReshapeFunc(reshape);
 	glutKeyboardFunc(keys);
 	glutKeyboardUpFunc(keysUp);
+	glutMouseFunc(mouse);
+	glutMotionFunc(motion);
 #endif
 
 #ifdef BUILD_GUI_EXT
 	gui_init();
+	// display() sets up the scene's state every frame, so the gui pass needn't save and restore it
+	gui_set_known_state(true);
+	// the options below can be combined in any order
+	// --record <file> logs the panel's input for a later --replay
+	const char* recordFile = optionValue(argc, argv, "--record");
+	if (recordFile != NULL && !gui_record(recordFile))
+	{
+		fprintf(stderr, "could not record to %s\n", recordFile);
+	}
+	// --poses <file> plays back a recorded pose file
+	const char* posesFile = optionValue(argc, argv, "--poses");
+	if (posesFile != NULL && !gui_open_poses(posesFile))
+	{
+		fprintf(stderr, "could not open pose file %s\n", posesFile);
+	}
 #endif
 
 	// world initialization and loop
 	init();
+#ifdef BUILD_GUI_EXT
+	// --crowd <count> adds that many gimbals below the primary, which the outliner lists and the gui
+	// rotates towards targets of their own
+	const char* crowdSize = optionValue(argc, argv, "--crowd");
+	if (crowdSize != NULL)
+	{
+		if (initCrowd((size_t)strtoul(crowdSize, NULL, 10)))
+		{
+			gui_set_scene(crowd, crowdTargets, crowdCount);
+		}
+		else
+		{
+			fprintf(stderr, "could not make a crowd of %s\n", crowdSize);
+		}
+	}
+	// --pairs <count> adds that many small primary and target pairs on a ring around the primary,
+	// each stepped by a controller of its own alongside the primary's and picked in the panel
+	const char* pairsSize = optionValue(argc, argv, "--pairs");
+	if (pairsSize != NULL)
+	{
+		if (initPairs((size_t)strtoul(pairsSize, NULL, 10)))
+		{
+			for (size_t pi = 0; pi < pairCount; ++pi)
+			{
+				gui_add_pair(&pairGimbals[pi], &pairTargets[pi]);
+			}
+		}
+		else
+		{
+			fprintf(stderr, "could not make %s pairs\n", pairsSize);
+		}
+	}
+	// --record-poses <file> writes the primary's and the crowd's poses to a pose file as they move,
+	// which --poses can open again; every gimbal is written on the first frame
+	const char* posesOut = optionValue(argc, argv, "--record-poses");
+	if (posesOut != NULL)
+	{
+		posesWritten = (Gimbal*)malloc((crowdCount + 1) * sizeof(Gimbal));
+		if (posesWritten != NULL && beginPoseFile(&poseWriter, posesOut))
+		{
+			for (size_t gi = 0; gi <= crowdCount; ++gi)
+			{
+				// a mode no gimbal has, so none matches what was written
+				posesWritten[gi].eulerMode = (enum EulerMode)-1;
+			}
+			posesStartMs = glutGet(GLUT_ELAPSED_TIME);
+		}
+		else
+		{
+			free(posesWritten);
+			posesWritten = NULL;
+			fprintf(stderr, "could not record poses to %s\n", posesOut);
+		}
+	}
+	// --waypoints <file> queues targets for the primary, and for the crowd's gimbals by index, from a
+	// file or from stdin with -; it comes after the crowd so the crowd's queues exist to be fed
+	const char* waypointsFile = optionValue(argc, argv, "--waypoints");
+	if (waypointsFile != NULL && !gui_feed_waypoints(waypointsFile))
+	{
+		fprintf(stderr, "could not read waypoints from %s\n", waypointsFile);
+	}
+#endif
 	glutMainLoop();
 
 #ifdef BUILD_GUI_EXT
 	gui_shutdown();
+	if (posesWritten != NULL && !endPoseFile(&poseWriter))
+	{
+		fprintf(stderr, "could not finish the pose file\n");
+	}
+	free(posesWritten);
+	free(crowd);
+	free(crowdTargets);
+	free(crowdCaches);
+	releasePickScene(&pickScene);
+	free(pickGimbals);
+	free(pickPositions);
+	free(pickScales);
+	free(pairGimbals);
+	free(pairTargets);
+	free(pairCaches);
 #endif
 }
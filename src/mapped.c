@@ -0,0 +1,134 @@
+#ifndef _WIN32
+	// madvise is outside POSIX
+	#define _DEFAULT_SOURCE
+	#define _POSIX_C_SOURCE 200809L
+#endif
+#include "mapped.h"
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool mapFile(MappedFile* mapped, const char* path)
+{
+	mapped->data = NULL;
+	mapped->size = 0;
+	mapped->mapping = NULL;
+	mapped->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (mapped->file == INVALID_HANDLE_VALUE)
+	{
+		mapped->file = NULL;
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mapped->file, &size) || size.QuadPart == 0)
+	{
+		unmapFile(mapped);
+		return false;
+	}
+
+	mapped->mapping = CreateFileMappingA(mapped->file, NULL, PAGE_READONLY, 0, 0, NULL);
+	mapped->data = mapped->mapping != NULL ? MapViewOfFile(mapped->mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (mapped->data == NULL)
+	{
+		unmapFile(mapped);
+		return false;
+	}
+	mapped->size = (size_t) size.QuadPart;
+	return true;
+}
+
+void unmapFile(MappedFile* mapped)
+{
+	if (mapped->data != NULL)
+	{
+		UnmapViewOfFile(mapped->data);
+	}
+	if (mapped->mapping != NULL)
+	{
+		CloseHandle(mapped->mapping);
+	}
+	if (mapped->file != NULL)
+	{
+		CloseHandle(mapped->file);
+	}
+	mapped->data = NULL;
+	mapped->size = 0;
+	mapped->mapping = NULL;
+	mapped->file = NULL;
+}
+
+void releaseMappedRange(const MappedFile* mapped, size_t offset, size_t size)
+{
+	if (mapped->data == NULL || offset >= mapped->size || size == 0)
+	{
+		return;
+	}
+	size = size < mapped->size - offset ? size : mapped->size - offset;
+	// unlocking pages that were never locked takes them out of the working set
+	VirtualUnlock((char*) mapped->data + offset, size);
+}
+
+#else
+
+bool mapFile(MappedFile* mapped, const char* path)
+{
+	mapped->data = NULL;
+	mapped->size = 0;
+	int file = open(path, O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	// the mapping holds its own reference to the file, so it can be closed straight away
+	struct stat info;
+	void* data = MAP_FAILED;
+	if (fstat(file, &info) == 0 && info.st_size > 0)
+	{
+		data = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	}
+	close(file);
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+	mapped->data = data;
+	mapped->size = (size_t) info.st_size;
+	return true;
+}
+
+void unmapFile(MappedFile* mapped)
+{
+	if (mapped->data != NULL)
+	{
+		munmap((void*) mapped->data, mapped->size);
+	}
+	mapped->data = NULL;
+	mapped->size = 0;
+}
+
+void releaseMappedRange(const MappedFile* mapped, size_t offset, size_t size)
+{
+	if (mapped->data == NULL || offset >= mapped->size || size == 0)
+	{
+		return;
+	}
+	size = size < mapped->size - offset ? size : mapped->size - offset;
+	// out to whole pages; the mapping is private and read-only, so a dropped page is only read again
+	size_t page = (size_t) sysconf(_SC_PAGESIZE);
+	size_t start = offset / page * page;
+	size_t end = offset + size;
+	madvise((char*) mapped->data + start, end - start, MADV_DONTNEED);
+}
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A whole file mapped read-only into memory. Pages are read in by the OS as they are touched, so
+// opening a large file costs nothing up front and its contents are shared with the page cache
+// rather than copied.
+typedef struct MappedFile
+{
+	const void* data;
+	size_t size;
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#endif
+} MappedFile;
+
+// returns false if the file can't be opened or is empty
+bool mapFile(MappedFile* mapped, const char* path);
+void unmapFile(MappedFile* mapped);
+// hands the pages covering a range back to the OS; they stay mapped and are read in again if touched
+void releaseMappedRange(const MappedFile* mapped, size_t offset, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,519 @@
+#include "picking.h"
+#include <math.h>
+#include <stdlib.h>
+
+//--------------------------------------------------------------------------------------------------
+// defines
+//--------------------------------------------------------------------------------------------------
+
+#define PI 3.14159265358979323846f
+#define DEG_TO_RAD (PI / 180.0f)
+
+// the rings are drawn as lines of radius 1, picked as tori this thick either side of the line
+#define RING_RADIUS 1.0f
+#define RING_TOLERANCE 0.06f
+// the arrow's shaft and head fit in a box this wide running from the centre to z = 1
+#define ARROW_HALF_WIDTH 0.2f
+#define ARROW_LENGTH 1.0f
+
+#define LEAF_SIZE 4
+// below this depth the tree is split spatially, after it by halving, so however the gimbals are
+// placed the tree is never deeper than this plus the 32 halvings a 32 bit count allows
+#define SPATIAL_DEPTH 32
+#define STACK_SIZE (SPATIAL_DEPTH + 34)
+// sphere tracing a torus converges in a few steps except for rays grazing its surface
+#define TRACE_STEPS 48
+#define TRACE_EPSILON 1e-4f
+
+// axes in the order drawGimbal rotates into them, outermost first, indexed by euler mode
+static const int drawOrder[6][3] = {
+	{ AXIS_Z, AXIS_Y, AXIS_X }, // EULER_MODE_XYZ
+	{ AXIS_Y, AXIS_Z, AXIS_X }, // EULER_MODE_XZY
+	{ AXIS_Z, AXIS_X, AXIS_Y }, // EULER_MODE_YXZ
+	{ AXIS_X, AXIS_Z, AXIS_Y }, // EULER_MODE_YZX
+	{ AXIS_Y, AXIS_X, AXIS_Z }, // EULER_MODE_ZXY
+	{ AXIS_X, AXIS_Y, AXIS_Z }  // EULER_MODE_ZYX
+};
+
+//--------------------------------------------------------------------------------------------------
+// prototypes
+//--------------------------------------------------------------------------------------------------
+
+static float dot( const float*, const float* );
+static void rotateFrame( float[9], int, float );
+static bool isSameShape( const PickShape*, const Gimbal*, const float*, float );
+static void computeShape( PickShape*, const Gimbal*, const float*, float );
+static void buildNode( PickScene*, uint32_t, uint32_t, uint32_t, int );
+static void fitLeaf( PickScene*, PickNode* );
+static bool hitBox( const Ray*, const float*, const float*, const float*, float, float* );
+static bool traceRing( const Ray*, const float*, const float*, float, float, float* );
+static bool hitArrow( const Ray*, const PickShape*, float, float* );
+
+//--------------------------------------------------------------------------------------------------
+// functions
+//--------------------------------------------------------------------------------------------------
+
+float dot( const float* a, const float* b )
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+void rotateFrame( float frame[9], int axis, float degrees )
+{
+	// post-multiplies like glRotatef: rotating about the axis turns its next column toward the one
+	// after, e.g. x toward y about z
+	float c = cosf( degrees * DEG_TO_RAD );
+	float s = sinf( degrees * DEG_TO_RAD );
+	float* u = &frame[3 * ((axis + 1) % 3)];
+	float* v = &frame[3 * ((axis + 2) % 3)];
+	for ( int i = 0; i < 3; ++i )
+	{
+		float fu = u[i];
+		float fv = v[i];
+		u[i] = c * fu + s * fv;
+		v[i] = c * fv - s * fu;
+	}
+}
+
+bool isSameShape( const PickShape* shape, const Gimbal* gimbal, const float* center, float scale )
+{
+	return shape->state.rotation[0] == gimbal->rotation[0] &&
+		shape->state.rotation[1] == gimbal->rotation[1] &&
+		shape->state.rotation[2] == gimbal->rotation[2] &&
+		shape->state.eulerMode == gimbal->eulerMode &&
+		shape->state.drawRotations == gimbal->drawRotations &&
+		shape->center[0] == center[0] &&
+		shape->center[1] == center[1] &&
+		shape->center[2] == center[2] &&
+		shape->scale == scale;
+}
+
+void computeShape( PickShape* shape, const Gimbal* gimbal, const float* center, float scale )
+{
+	shape->state = *gimbal;
+	shape->scale = scale;
+	for ( int i = 0; i < 3; ++i )
+	{
+		shape->center[i] = center[i];
+	}
+
+	// each ring lies across its axis in the frame it is drawn in, the rotations outside it; turning
+	// about the ring's own axis leaves it where it is
+	static const float identity[9] = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+	for ( int i = 0; i < 9; ++i )
+	{
+		shape->frame[i] = identity[i];
+	}
+	for ( int i = 0; i < 3; ++i )
+	{
+		int axis = drawOrder[gimbal->eulerMode][i];
+		rotateFrame( shape->frame, axis, gimbal->rotation[axis] );
+		for ( int j = 0; j < 3; ++j )
+		{
+			shape->ringNormals[axis][j] = shape->frame[3 * axis + j];
+		}
+	}
+
+	// the rings fill a sphere whichever way they turn, the arrow's box is turned with the gimbal
+	float extent = gimbal->drawRotations ? (RING_RADIUS + RING_TOLERANCE) * scale : 0.0f;
+	for ( int i = 0; i < 3; ++i )
+	{
+		shape->min[i] = center[i] - extent;
+		shape->max[i] = center[i] + extent;
+	}
+	for ( int corner = 0; corner < 8; ++corner )
+	{
+		float local[3] = {
+			(corner & 1 ? ARROW_HALF_WIDTH : -ARROW_HALF_WIDTH) * scale,
+			(corner & 2 ? ARROW_HALF_WIDTH : -ARROW_HALF_WIDTH) * scale,
+			corner & 4 ? ARROW_LENGTH * scale : 0.0f
+		};
+		for ( int i = 0; i < 3; ++i )
+		{
+			float world = center[i] + shape->frame[i] * local[0] + shape->frame[3 + i] * local[1] + shape->frame[6 + i] * local[2];
+			shape->min[i] = fminf( shape->min[i], world );
+			shape->max[i] = fmaxf( shape->max[i], world );
+		}
+	}
+}
+
+void buildNode( PickScene* scene, uint32_t index, uint32_t start, uint32_t count, int depth )
+{
+	PickNode* node = &scene->nodes[index];
+	node->start = start;
+	node->count = count;
+	fitLeaf( scene, node );
+	if ( count <= LEAF_SIZE )
+	{
+		for ( uint32_t i = start; i < start + count; ++i )
+		{
+			scene->leaves[i] = index;
+		}
+		return;
+	}
+
+	// split the centres at the middle of their widest extent
+	float low[3] = { INFINITY, INFINITY, INFINITY };
+	float high[3] = { -INFINITY, -INFINITY, -INFINITY };
+	for ( uint32_t i = start; i < start + count; ++i )
+	{
+		const float* center = scene->shapes[i].center;
+		for ( int j = 0; j < 3; ++j )
+		{
+			low[j] = fminf( low[j], center[j] );
+			high[j] = fmaxf( high[j], center[j] );
+		}
+	}
+	int axis = 0;
+	for ( int j = 1; j < 3; ++j )
+	{
+		axis = high[j] - low[j] > high[axis] - low[axis] ? j : axis;
+	}
+	float middle = 0.5f * (low[axis] + high[axis]);
+
+	uint32_t first = start;
+	uint32_t last = start + count;
+	while ( first < last )
+	{
+		if ( scene->shapes[first].center[axis] < middle )
+		{
+			++first;
+		}
+		else
+		{
+			--last;
+			PickShape shape = scene->shapes[first];
+			scene->shapes[first] = scene->shapes[last];
+			scene->shapes[last] = shape;
+			uint32_t index = scene->order[first];
+			scene->order[first] = scene->order[last];
+			scene->order[last] = index;
+		}
+	}
+	// centres all in one place can't be split spatially, any halving will do
+	uint32_t half = first - start;
+	if ( half == 0 || half == count || depth >= SPATIAL_DEPTH )
+	{
+		half = count / 2;
+	}
+
+	// children always come after their parent, which is what lets a refit run backwards
+	uint32_t children = (uint32_t)scene->nodeCount;
+	scene->nodeCount += 2;
+	node->start = children;
+	node->count = 0;
+	buildNode( scene, children, start, half, depth + 1 );
+	buildNode( scene, children + 1, start + half, count - half, depth + 1 );
+}
+
+void fitLeaf( PickScene* scene, PickNode* node )
+{
+	for ( int j = 0; j < 3; ++j )
+	{
+		node->min[j] = INFINITY;
+		node->max[j] = -INFINITY;
+	}
+	for ( uint32_t i = node->start; i < node->start + node->count; ++i )
+	{
+		const PickShape* shape = &scene->shapes[i];
+		for ( int j = 0; j < 3; ++j )
+		{
+			node->min[j] = fminf( node->min[j], shape->min[j] );
+			node->max[j] = fmaxf( node->max[j], shape->max[j] );
+		}
+	}
+}
+
+bool buildPickScene(PickScene* scene, const Gimbal* gimbals, const Vec3* positions, const float* scales, size_t count)
+{
+	scene->gimbals = gimbals;
+	scene->positions = positions;
+	scene->scales = scales;
+	scene->count = count;
+	scene->nodeCount = 0;
+	size_t slots = count > 0 ? count : 1;
+	scene->shapes = malloc( sizeof(PickShape) * slots );
+	scene->order = malloc( sizeof(uint32_t) * slots );
+	scene->leaves = malloc( sizeof(uint32_t) * slots );
+	// a binary tree over count leaves of at least one gimbal has fewer than 2 * count nodes
+	scene->nodes = malloc( sizeof(PickNode) * 2 * slots );
+	scene->dirty = calloc( 2 * slots, 1 );
+	if ( scene->shapes == NULL || scene->order == NULL || scene->leaves == NULL || scene->nodes == NULL || scene->dirty == NULL || count > UINT32_MAX )
+	{
+		releasePickScene( scene );
+		return false;
+	}
+
+	static const float origin[3] = { 0.0f, 0.0f, 0.0f };
+	for ( size_t i = 0; i < count; ++i )
+	{
+		computeShape( &scene->shapes[i], &gimbals[i], positions != NULL ? positions[i] : origin, scales != NULL ? scales[i] : 1.0f );
+		scene->order[i] = (uint32_t)i;
+	}
+	if ( count > 0 )
+	{
+		scene->nodeCount = 1;
+		buildNode( scene, 0, 0, (uint32_t)count, 0 );
+	}
+	return true;
+}
+
+void refitPickScene(PickScene* scene)
+{
+	static const float origin[3] = { 0.0f, 0.0f, 0.0f };
+	bool changed = false;
+	for ( size_t i = 0; i < scene->count; ++i )
+	{
+		uint32_t index = scene->order[i];
+		const float* center = scene->positions != NULL ? scene->positions[index] : origin;
+		float scale = scene->scales != NULL ? scene->scales[index] : 1.0f;
+		if ( !isSameShape( &scene->shapes[i], &scene->gimbals[index], center, scale ) )
+		{
+			computeShape( &scene->shapes[i], &scene->gimbals[index], center, scale );
+			scene->dirty[scene->leaves[i]] = 1;
+			changed = true;
+		}
+	}
+	if ( !changed )
+	{
+		return;
+	}
+
+	// the split stays as built, only the boxes above a changed gimbal grow or shrink to its new bounds
+	for ( size_t i = scene->nodeCount; i-- > 0; )
+	{
+		PickNode* node = &scene->nodes[i];
+		if ( node->count > 0 )
+		{
+			if ( scene->dirty[i] )
+			{
+				fitLeaf( scene, node );
+			}
+			continue;
+		}
+		if ( !scene->dirty[node->start] && !scene->dirty[node->start + 1] )
+		{
+			continue;
+		}
+		const PickNode* left = &scene->nodes[node->start];
+		const PickNode* right = &scene->nodes[node->start + 1];
+		for ( int j = 0; j < 3; ++j )
+		{
+			node->min[j] = fminf( left->min[j], right->min[j] );
+			node->max[j] = fmaxf( left->max[j], right->max[j] );
+		}
+		scene->dirty[node->start] = 0;
+		scene->dirty[node->start + 1] = 0;
+		scene->dirty[i] = 1;
+	}
+	scene->dirty[0] = 0;
+}
+
+void releasePickScene(PickScene* scene)
+{
+	free( scene->shapes );
+	free( scene->order );
+	free( scene->leaves );
+	free( scene->nodes );
+	free( scene->dirty );
+	scene->shapes = NULL;
+	scene->order = NULL;
+	scene->leaves = NULL;
+	scene->nodes = NULL;
+	scene->dirty = NULL;
+	scene->count = 0;
+	scene->nodeCount = 0;
+}
+
+bool hitBox( const Ray* ray, const float* inverse, const float* min, const float* max, float limit, float* distance )
+{
+	float near = 0.0f;
+	float far = limit;
+	for ( int i = 0; i < 3; ++i )
+	{
+		float t0 = (min[i] - ray->origin[i]) * inverse[i];
+		float t1 = (max[i] - ray->origin[i]) * inverse[i];
+		near = fmaxf( near, fminf( t0, t1 ) );
+		far = fminf( far, fmaxf( t0, t1 ) );
+	}
+	*distance = near;
+	return near <= far;
+}
+
+bool traceRing( const Ray* ray, const float* center, const float* normal, float scale, float limit, float* distance )
+{
+	// only march through the sphere the torus sits in
+	float offset[3] = { ray->origin[0] - center[0], ray->origin[1] - center[1], ray->origin[2] - center[2] };
+	float radius = RING_RADIUS * scale;
+	float tolerance = RING_TOLERANCE * scale;
+	float bound = radius + tolerance;
+	float b = dot( offset, ray->direction );
+	float discriminant = b * b - (dot( offset, offset ) - bound * bound);
+	if ( discriminant < 0.0f )
+	{
+		return false;
+	}
+	float root = sqrtf( discriminant );
+	float t = fmaxf( -b - root, 0.0f );
+	float exit = fminf( -b + root, limit );
+
+	for ( int step = 0; step < TRACE_STEPS && t <= exit; ++step )
+	{
+		// distance to the torus: from the point to the nearest point on the circle, less the tube
+		float v[3];
+		for ( int i = 0; i < 3; ++i )
+		{
+			v[i] = offset[i] + ray->direction[i] * t;
+		}
+		float height = dot( v, normal );
+		float planar = sqrtf( fmaxf( dot( v, v ) - height * height, 0.0f ) ) - radius;
+		float gap = sqrtf( planar * planar + height * height ) - tolerance;
+		if ( gap < TRACE_EPSILON )
+		{
+			*distance = t;
+			return true;
+		}
+		t += gap;
+	}
+	return false;
+}
+
+bool hitArrow( const Ray* ray, const PickShape* shape, float limit, float* distance )
+{
+	// into the arrow's frame, where its box is axis aligned and full size; the direction is scaled
+	// with the origin, so distances along the ray stay in world units
+	float offset[3] = { ray->origin[0] - shape->center[0], ray->origin[1] - shape->center[1], ray->origin[2] - shape->center[2] };
+	Ray local;
+	float inverse[3];
+	for ( int i = 0; i < 3; ++i )
+	{
+		local.origin[i] = dot( &shape->frame[3 * i], offset ) / shape->scale;
+		local.direction[i] = dot( &shape->frame[3 * i], ray->direction ) / shape->scale;
+		inverse[i] = 1.0f / local.direction[i];
+	}
+	static const float min[3] = { -ARROW_HALF_WIDTH, -ARROW_HALF_WIDTH, 0.0f };
+	static const float max[3] = { ARROW_HALF_WIDTH, ARROW_HALF_WIDTH, ARROW_LENGTH };
+	return hitBox( &local, inverse, min, max, limit, distance );
+}
+
+bool pickRay(const PickScene* scene, const Ray* ray, PickHit* hit)
+{
+	hit->part = PICK_NONE;
+	hit->axis = AXIS_NONE;
+	hit->distance = INFINITY;
+	if ( scene->nodeCount == 0 )
+	{
+		return false;
+	}
+
+	float inverse[3] = { 1.0f / ray->direction[0], 1.0f / ray->direction[1], 1.0f / ray->direction[2] };
+	uint32_t stack[STACK_SIZE];
+	int top = 0;
+	stack[top++] = 0;
+	while ( top > 0 )
+	{
+		const PickNode* node = &scene->nodes[stack[--top]];
+		float entry;
+		if ( !hitBox( ray, inverse, node->min, node->max, hit->distance, &entry ) )
+		{
+			continue;
+		}
+
+		if ( node->count == 0 )
+		{
+			// visit the nearer child first so it can cut the farther one short
+			float leftEntry;
+			float rightEntry;
+			bool left = hitBox( ray, inverse, scene->nodes[node->start].min, scene->nodes[node->start].max, hit->distance, &leftEntry );
+			bool right = hitBox( ray, inverse, scene->nodes[node->start + 1].min, scene->nodes[node->start + 1].max, hit->distance, &rightEntry );
+			if ( left && right && top + 2 <= STACK_SIZE )
+			{
+				stack[top++] = leftEntry < rightEntry ? node->start + 1 : node->start;
+				stack[top++] = leftEntry < rightEntry ? node->start : node->start + 1;
+			}
+			else if ( (left || right) && top < STACK_SIZE )
+			{
+				stack[top++] = left ? node->start : node->start + 1;
+			}
+			continue;
+		}
+
+		for ( uint32_t i = node->start; i < node->start + node->count; ++i )
+		{
+			uint32_t index = scene->order[i];
+			const PickShape* shape = &scene->shapes[i];
+			float distance;
+			if ( shape->state.drawRotations )
+			{
+				for ( int axis = AXIS_X; axis <= AXIS_Z; ++axis )
+				{
+					if ( traceRing( ray, shape->center, shape->ringNormals[axis], shape->scale, hit->distance, &distance ) && distance < hit->distance )
+					{
+						hit->gimbal = index;
+						hit->part = PICK_RING;
+						hit->axis = (enum Axis)axis;
+						hit->distance = distance;
+					}
+				}
+			}
+			if ( hitArrow( ray, shape, hit->distance, &distance ) && distance < hit->distance )
+			{
+				hit->gimbal = index;
+				hit->part = PICK_ARROW;
+				hit->axis = AXIS_NONE;
+				hit->distance = distance;
+			}
+		}
+	}
+	return hit->part != PICK_NONE;
+}
+
+Ray cameraRay(const Camera* camera, float fovDegrees, int width, int height, int x, int y)
+{
+	width = width > 0 ? width : 1;
+	height = height > 0 ? height : 1;
+
+	// the same basis gluLookAt builds
+	float forward[3];
+	for ( int i = 0; i < 3; ++i )
+	{
+		forward[i] = camera->lookat[i] - camera->position[i];
+	}
+	float length = sqrtf( dot( forward, forward ) );
+	float right[3] = {
+		forward[1] * camera->up[2] - forward[2] * camera->up[1],
+		forward[2] * camera->up[0] - forward[0] * camera->up[2],
+		forward[0] * camera->up[1] - forward[1] * camera->up[0]
+	};
+	float rightLength = sqrtf( dot( right, right ) );
+	for ( int i = 0; i < 3; ++i )
+	{
+		forward[i] /= length;
+		right[i] /= rightLength;
+	}
+	float up[3] = {
+		right[1] * forward[2] - right[2] * forward[1],
+		right[2] * forward[0] - right[0] * forward[2],
+		right[0] * forward[1] - right[1] * forward[0]
+	};
+
+	// the pixel centre on the image plane one unit in front of the eye
+	float halfHeight = tanf( 0.5f * fovDegrees * DEG_TO_RAD );
+	float halfWidth = halfHeight * (float)width / (float)height;
+	float u = (2.0f * ((float)x + 0.5f) / (float)width - 1.0f) * halfWidth;
+	float v = (1.0f - 2.0f * ((float)y + 0.5f) / (float)height) * halfHeight;
+
+	Ray ray;
+	float direction[3];
+	for ( int i = 0; i < 3; ++i )
+	{
+		ray.origin[i] = camera->position[i];
+		direction[i] = forward[i] + right[i] * u + up[i] * v;
+	}
+	float directionLength = sqrtf( dot( direction, direction ) );
+	for ( int i = 0; i < 3; ++i )
+	{
+		ray.direction[i] = direction[i] / directionLength;
+	}
+	return ray;
+}
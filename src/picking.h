@@ -0,0 +1,83 @@
+#pragma once
+#include "gimbal.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Ray
+{
+	Vec3 origin;
+	Vec3 direction; // unit length
+} Ray;
+
+enum PickPart
+{
+	PICK_NONE,
+	PICK_RING,
+	PICK_ARROW
+};
+
+typedef struct PickHit
+{
+	size_t gimbal;      // index into the scene's gimbals
+	enum PickPart part;
+	enum Axis axis;     // the ring's axis, AXIS_NONE for the arrow
+	float distance;     // along the ray
+} PickHit;
+
+// where a gimbal's pickable parts are in world space, worked out from its rotation once per change
+typedef struct PickShape
+{
+	Gimbal state;        // the gimbal as the shape was computed from it
+	Vec3 center;
+	float scale;         // of the gimbal as drawn, about its centre
+	float frame[9];      // the arrow's rotation, column major
+	Vec3 ringNormals[3]; // by axis
+	Vec3 min;
+	Vec3 max;
+} PickShape;
+
+typedef struct PickNode
+{
+	Vec3 min;
+	Vec3 max;
+	uint32_t start; // first child for an inner node, first shape for a leaf
+	uint32_t count; // 0 for an inner node, whose children are start and start + 1
+} PickNode;
+
+// A bounding volume hierarchy over a set of gimbals for casting rays against their rings and arrows.
+// The tree is split on the gimbals' positions when built; after that a refit only recomputes the
+// bounds of gimbals whose rotation changed, and the boxes above them, so the tree can follow
+// animated gimbals without being rebuilt.
+typedef struct PickScene
+{
+	const Gimbal* gimbals;
+	const Vec3* positions; // NULL for every gimbal at the origin, as drawGimbal places them
+	const float* scales;   // NULL for every gimbal at the size drawGimbal draws it
+	size_t count;
+	PickShape* shapes;     // in tree order, so each leaf's shapes are next to each other
+	uint32_t* order;       // the gimbal each shape is of
+	uint32_t* leaves;      // the leaf each shape is in
+	PickNode* nodes;
+	size_t nodeCount;
+	unsigned char* dirty;  // nodes whose bounds a refit has to recompute
+} PickScene;
+
+// the gimbals, positions and scales are read again by every refit, so they must outlive the scene
+bool buildPickScene(PickScene* scene, const Gimbal* gimbals, const Vec3* positions, const float* scales, size_t count);
+// call after changing rotations, euler modes, positions, scales or whether rings are drawn
+void refitPickScene(PickScene* scene);
+void releasePickScene(PickScene* scene);
+// finds the nearest ring or arrow along the ray; rings are only hit where drawRotations shows them
+bool pickRay(const PickScene* scene, const Ray* ray, PickHit* hit);
+
+// the ray through a window pixel, y down as GLUT reports it, for a perspective camera with the
+// given vertical field of view
+Ray cameraRay(const Camera* camera, float fovDegrees, int width, int height, int x, int y);
+
+#ifdef __cplusplus
+}
+#endif
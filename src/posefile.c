@@ -0,0 +1,370 @@
+#include "posefile.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+//--------------------------------------------------------------------------------------------------
+// defines
+//--------------------------------------------------------------------------------------------------
+
+// bytes per frame across all the columns of a chunk
+#define POSE_FRAME_BYTES (sizeof(double) + 3 * sizeof(float) + sizeof(uint32_t) + sizeof(uint8_t))
+
+typedef struct PoseFileHeader
+{
+	char magic[4]; // "GPOS"
+	uint32_t version;
+	uint32_t chunkAlignment;
+	uint32_t reserved;
+} PoseFileHeader;
+
+static const char headerMagic[4] = { 'G', 'P', 'O', 'S' };
+static const char trailerMagic[4] = { 'G', 'P', 'I', 'X' };
+
+//--------------------------------------------------------------------------------------------------
+// prototypes
+//--------------------------------------------------------------------------------------------------
+
+static bool isLittleEndian( void );
+static bool writePadding( PoseWriter* );
+static bool writeBytes( PoseWriter*, const void*, size_t );
+static bool flushChunk( PoseWriter* );
+static void freeBuffers( PoseWriter* );
+
+//--------------------------------------------------------------------------------------------------
+// reading
+//--------------------------------------------------------------------------------------------------
+
+bool isLittleEndian( void )
+{
+	// the columns are mapped and read in place, so a big-endian host can't use them as they are
+	const uint16_t one = 1;
+	return *(const uint8_t*)&one == 1;
+}
+
+bool openPoseFile(PoseFile* file, const char* path)
+{
+	file->index = NULL;
+	file->chunkCount = 0;
+	file->frameCount = 0;
+	if ( !isLittleEndian() || !mapFile( &file->mapped, path ) )
+	{
+		return false;
+	}
+
+	const unsigned char* data = file->mapped.data;
+	size_t size = file->mapped.size;
+	PoseFileHeader header;
+	PoseFileTrailer trailer;
+	if ( size < POSE_CHUNK_ALIGNMENT + sizeof(trailer) )
+	{
+		closePoseFile( file );
+		return false;
+	}
+	memcpy( &header, data, sizeof(header) );
+	memcpy( &trailer, data + size - sizeof(trailer), sizeof(trailer) );
+	size_t indexEnd = size - sizeof(trailer);
+	if ( memcmp( header.magic, headerMagic, 4 ) != 0 || header.version != POSE_FILE_VERSION
+		|| header.chunkAlignment != POSE_CHUNK_ALIGNMENT
+		|| memcmp( trailer.magic, trailerMagic, 4 ) != 0 || trailer.version != POSE_FILE_VERSION
+		|| trailer.indexOffset % sizeof(uint64_t) != 0 || trailer.indexOffset > indexEnd
+		|| trailer.chunkCount != (indexEnd - trailer.indexOffset) / sizeof(PoseChunkEntry) )
+	{
+		closePoseFile( file );
+		return false;
+	}
+
+	// every chunk has to lie between the header and the index, after the one before it, so no column
+	// is read out of bounds; the bounds are compared without adding to the offset, which could wrap.
+	// The chunks' times have to run in order too, as findPoseChunk bisects them
+	const PoseChunkEntry* index = (const PoseChunkEntry*)(data + trailer.indexOffset);
+	uint64_t frames = 0;
+	uint64_t chunkEnd = POSE_CHUNK_ALIGNMENT;
+	for ( size_t i = 0; i < trailer.chunkCount; ++i )
+	{
+		if ( index[i].offset % POSE_CHUNK_ALIGNMENT != 0 || index[i].offset < chunkEnd
+			|| index[i].offset > trailer.indexOffset
+			|| index[i].frames > (trailer.indexOffset - index[i].offset) / POSE_FRAME_BYTES
+			|| !(index[i].firstTime <= index[i].lastTime)
+			|| ( i > 0 && !(index[i].firstTime >= index[i - 1].lastTime) ) )
+		{
+			closePoseFile( file );
+			return false;
+		}
+		chunkEnd = index[i].offset + (uint64_t)index[i].frames * POSE_FRAME_BYTES;
+		frames += index[i].frames;
+	}
+	if ( frames != trailer.frameCount )
+	{
+		closePoseFile( file );
+		return false;
+	}
+
+	file->index = index;
+	file->chunkCount = (size_t)trailer.chunkCount;
+	file->frameCount = trailer.frameCount;
+	return true;
+}
+
+void closePoseFile(PoseFile* file)
+{
+	unmapFile( &file->mapped );
+	file->index = NULL;
+	file->chunkCount = 0;
+	file->frameCount = 0;
+}
+
+PoseChunk getPoseChunk(const PoseFile* file, size_t chunk)
+{
+	const PoseChunkEntry* entry = &file->index[chunk];
+	const unsigned char* base = (const unsigned char*)file->mapped.data + entry->offset;
+	size_t count = entry->frames;
+
+	PoseChunk columns;
+	columns.count = count;
+	columns.time = (const double*)base;
+	columns.x = (const float*)(base + count * sizeof(double));
+	columns.y = columns.x + count;
+	columns.z = columns.y + count;
+	columns.gimbal = (const uint32_t*)(columns.z + count);
+	columns.eulerMode = (const uint8_t*)(columns.gimbal + count);
+	return columns;
+}
+
+size_t findPoseChunk(const PoseFile* file, double time)
+{
+	// only the index is searched, so no chunk is paged in to find one
+	size_t low = 0;
+	size_t high = file->chunkCount;
+	while ( high - low > 1 )
+	{
+		size_t middle = low + (high - low) / 2;
+		if ( file->index[middle].firstTime <= time )
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+	return low;
+}
+
+bool samplePose(const PoseFile* file, uint32_t gimbal, double time, size_t lookBack, float rotation[3], enum EulerMode* eulerMode)
+{
+	if ( file->chunkCount == 0 )
+	{
+		return false;
+	}
+
+	size_t chunk = findPoseChunk( file, time );
+	size_t last = chunk > lookBack ? chunk - lookBack : 0;
+	for ( size_t c = chunk + 1; c-- > last; )
+	{
+		PoseChunk columns = getPoseChunk( file, c );
+
+		// the frames after the time, found by bisecting the time column
+		size_t end = columns.count;
+		if ( c == chunk )
+		{
+			size_t low = 0;
+			while ( low < end )
+			{
+				size_t middle = low + (end - low) / 2;
+				if ( columns.time[middle] <= time )
+				{
+					low = middle + 1;
+				}
+				else
+				{
+					end = middle;
+				}
+			}
+		}
+
+		for ( size_t i = end; i-- > 0; )
+		{
+			if ( columns.gimbal[i] == gimbal )
+			{
+				rotation[0] = columns.x[i];
+				rotation[1] = columns.y[i];
+				rotation[2] = columns.z[i];
+				*eulerMode = columns.eulerMode[i] <= EULER_MODE_ZYX ? (enum EulerMode)columns.eulerMode[i] : EULER_MODE_XYZ;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void releasePoseChunks(const PoseFile* file, size_t first, size_t count)
+{
+	if ( first >= file->chunkCount || count == 0 )
+	{
+		return;
+	}
+	size_t end = first + count < file->chunkCount ? first + count : file->chunkCount;
+	const PoseChunkEntry* last = &file->index[end - 1];
+	size_t start = (size_t)file->index[first].offset;
+	size_t stop = (size_t)(last->offset + (uint64_t)last->frames * POSE_FRAME_BYTES);
+	releaseMappedRange( &file->mapped, start, stop - start );
+}
+
+//--------------------------------------------------------------------------------------------------
+// writing
+//--------------------------------------------------------------------------------------------------
+
+bool writeBytes( PoseWriter* writer, const void* data, size_t size )
+{
+	if ( size > 0 && fwrite( data, 1, size, writer->file ) != size )
+	{
+		writer->failed = true;
+	}
+	writer->offset += size;
+	return !writer->failed;
+}
+
+bool writePadding( PoseWriter* writer )
+{
+	static const unsigned char zeros[POSE_CHUNK_ALIGNMENT] = { 0 };
+	size_t padding = (size_t)((POSE_CHUNK_ALIGNMENT - writer->offset % POSE_CHUNK_ALIGNMENT) % POSE_CHUNK_ALIGNMENT);
+	return writeBytes( writer, zeros, padding );
+}
+
+bool flushChunk( PoseWriter* writer )
+{
+	if ( writer->count == 0 )
+	{
+		return !writer->failed;
+	}
+
+	if ( writer->chunkCount == writer->chunkCapacity )
+	{
+		size_t capacity = writer->chunkCapacity > 0 ? writer->chunkCapacity * 2 : 64;
+		PoseChunkEntry* resized = realloc( writer->index, sizeof(PoseChunkEntry) * capacity );
+		if ( resized == NULL )
+		{
+			writer->failed = true;
+			return false;
+		}
+		writer->index = resized;
+		writer->chunkCapacity = capacity;
+	}
+
+	PoseChunkEntry* entry = &writer->index[writer->chunkCount++];
+	size_t count = writer->count;
+	entry->offset = writer->offset;
+	entry->frames = (uint32_t)count;
+	entry->reserved = 0;
+	entry->firstTime = writer->time[0];
+	entry->lastTime = writer->time[count - 1];
+
+	writeBytes( writer, writer->time, sizeof(double) * count );
+	writeBytes( writer, writer->x, sizeof(float) * count );
+	writeBytes( writer, writer->y, sizeof(float) * count );
+	writeBytes( writer, writer->z, sizeof(float) * count );
+	writeBytes( writer, writer->gimbal, sizeof(uint32_t) * count );
+	writeBytes( writer, writer->eulerMode, sizeof(uint8_t) * count );
+	writePadding( writer );
+	writer->frameCount += count;
+	writer->count = 0;
+	return !writer->failed;
+}
+
+void freeBuffers( PoseWriter* writer )
+{
+	free( writer->time );
+	free( writer->x );
+	free( writer->y );
+	free( writer->z );
+	free( writer->gimbal );
+	free( writer->eulerMode );
+	free( writer->index );
+	writer->time = NULL;
+	writer->x = NULL;
+	writer->y = NULL;
+	writer->z = NULL;
+	writer->gimbal = NULL;
+	writer->eulerMode = NULL;
+	writer->index = NULL;
+}
+
+bool beginPoseFile(PoseWriter* writer, const char* path)
+{
+	memset( writer, 0, sizeof(*writer) );
+	writer->lastTime = -INFINITY;
+	if ( !isLittleEndian() )
+	{
+		return false;
+	}
+
+	writer->time = malloc( sizeof(double) * POSE_CHUNK_FRAMES );
+	writer->x = malloc( sizeof(float) * POSE_CHUNK_FRAMES );
+	writer->y = malloc( sizeof(float) * POSE_CHUNK_FRAMES );
+	writer->z = malloc( sizeof(float) * POSE_CHUNK_FRAMES );
+	writer->gimbal = malloc( sizeof(uint32_t) * POSE_CHUNK_FRAMES );
+	writer->eulerMode = malloc( sizeof(uint8_t) * POSE_CHUNK_FRAMES );
+	writer->file = fopen( path, "wb" );
+	if ( writer->time == NULL || writer->x == NULL || writer->y == NULL || writer->z == NULL
+		|| writer->gimbal == NULL || writer->eulerMode == NULL || writer->file == NULL )
+	{
+		if ( writer->file != NULL )
+		{
+			fclose( writer->file );
+			writer->file = NULL;
+		}
+		freeBuffers( writer );
+		return false;
+	}
+
+	PoseFileHeader header;
+	memcpy( header.magic, headerMagic, 4 );
+	header.version = POSE_FILE_VERSION;
+	header.chunkAlignment = POSE_CHUNK_ALIGNMENT;
+	header.reserved = 0;
+	writeBytes( writer, &header, sizeof(header) );
+	return writePadding( writer );
+}
+
+bool writePose(PoseWriter* writer, double time, uint32_t gimbal, const float rotation[3], enum EulerMode eulerMode)
+{
+	if ( writer->file == NULL || writer->failed || !(time >= writer->lastTime) )
+	{
+		return false;
+	}
+
+	size_t i = writer->count++;
+	writer->time[i] = time;
+	writer->x[i] = rotation[0];
+	writer->y[i] = rotation[1];
+	writer->z[i] = rotation[2];
+	writer->gimbal[i] = gimbal;
+	writer->eulerMode[i] = (uint8_t)eulerMode;
+	writer->lastTime = time;
+	return writer->count < POSE_CHUNK_FRAMES || flushChunk( writer );
+}
+
+bool endPoseFile(PoseWriter* writer)
+{
+	if ( writer->file == NULL )
+	{
+		return false;
+	}
+
+	flushChunk( writer );
+	PoseFileTrailer trailer;
+	trailer.indexOffset = writer->offset;
+	trailer.chunkCount = writer->chunkCount;
+	trailer.frameCount = writer->frameCount;
+	memcpy( trailer.magic, trailerMagic, 4 );
+	trailer.version = POSE_FILE_VERSION;
+	writeBytes( writer, writer->index, sizeof(PoseChunkEntry) * writer->chunkCount );
+	writeBytes( writer, &trailer, sizeof(trailer) );
+
+	bool written = !writer->failed;
+	written = fclose( writer->file ) == 0 && written;
+	writer->file = NULL;
+	freeBuffers( writer );
+	return written;
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include "gimbal.h"
+#include "mapped.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pose files hold recorded rotations of any number of gimbals, sorted by time. All values are
+// little-endian.
+//
+//   header   "GPOS", version, chunk alignment, padded out to the alignment
+//   chunks   each starting on the alignment, holding its frames column by column:
+//            double time[n], float x[n], float y[n], float z[n], uint32 gimbal[n], uint8 mode[n]
+//   index    one PoseChunkEntry per chunk
+//   trailer  PoseFileTrailer, the last bytes of the file
+//
+// Opening a file only reads the header and the trailer and index at the end, and a chunk's pages
+// are only read in when its columns are touched, so the time to open doesn't depend on the size.
+#define POSE_FILE_VERSION 1
+#define POSE_CHUNK_ALIGNMENT 4096
+#define POSE_CHUNK_FRAMES 65536
+
+typedef struct PoseChunkEntry
+{
+	uint64_t offset;
+	uint32_t frames;
+	uint32_t reserved;
+	double firstTime;
+	double lastTime;
+} PoseChunkEntry;
+
+typedef struct PoseFileTrailer
+{
+	uint64_t indexOffset;
+	uint64_t chunkCount;
+	uint64_t frameCount;
+	char magic[4]; // "GPIX"
+	uint32_t version;
+} PoseFileTrailer;
+
+// one chunk's columns, pointing into the mapped file
+typedef struct PoseChunk
+{
+	size_t count;
+	const double* time;
+	const float* x;
+	const float* y;
+	const float* z;
+	const uint32_t* gimbal;
+	const uint8_t* eulerMode;
+} PoseChunk;
+
+typedef struct PoseFile
+{
+	MappedFile mapped;
+	const PoseChunkEntry* index;
+	size_t chunkCount;
+	uint64_t frameCount;
+} PoseFile;
+
+// returns false if the file can't be mapped or isn't a pose file this version can read; the index
+// is checked against the file size, so a truncated file is refused rather than read past its end
+bool openPoseFile(PoseFile* file, const char* path);
+void closePoseFile(PoseFile* file);
+PoseChunk getPoseChunk(const PoseFile* file, size_t chunk);
+// the last chunk starting at or before the time, or the first if the time is before them all
+size_t findPoseChunk(const PoseFile* file, double time);
+// the pose of a gimbal at the latest frame at or before the time, looking back at most lookBack
+// chunks before the one holding the time; returns false if there is none
+bool samplePose(const PoseFile* file, uint32_t gimbal, double time, size_t lookBack, float rotation[3], enum EulerMode* eulerMode);
+// drops the pages of a run of chunks from memory, e.g. once they have scrolled out of view
+void releasePoseChunks(const PoseFile* file, size_t first, size_t count);
+
+// Writes frames a chunk at a time; only the chunk being filled and the index are held in memory.
+typedef struct PoseWriter
+{
+	FILE* file;
+	uint64_t offset;
+	double lastTime;
+	// the chunk being filled, column by column
+	size_t count;
+	double* time;
+	float* x;
+	float* y;
+	float* z;
+	uint32_t* gimbal;
+	uint8_t* eulerMode;
+	PoseChunkEntry* index;
+	size_t chunkCount;
+	size_t chunkCapacity;
+	uint64_t frameCount;
+	bool failed;
+} PoseWriter;
+
+bool beginPoseFile(PoseWriter* writer, const char* path);
+// frames must come in time order; returns false for one that doesn't, or once a write has failed
+bool writePose(PoseWriter* writer, double time, uint32_t gimbal, const float rotation[3], enum EulerMode eulerMode);
+// writes the last chunk, the index and the trailer; returns false if anything failed to write
+bool endPoseFile(PoseWriter* writer);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,305 @@
+#include "rotation.h"
+#include <math.h>
+
+//--------------------------------------------------------------------------------------------------
+// defines
+//--------------------------------------------------------------------------------------------------
+
+#define PI 3.14159265358979323846f
+#define DEG_TO_RAD (PI / 180.0f)
+#define RAD_TO_DEG (180.0f / PI)
+// below this the arc between two quaternions is too short to divide by its sine
+#define SLERP_EPSILON 1e-5f
+
+// axes in the order drawGimbal applies them to the arrow, indexed by euler mode
+static const int applyOrder[6][3] = {
+	{ AXIS_X, AXIS_Y, AXIS_Z }, // EULER_MODE_XYZ
+	{ AXIS_X, AXIS_Z, AXIS_Y }, // EULER_MODE_XZY
+	{ AXIS_Y, AXIS_X, AXIS_Z }, // EULER_MODE_YXZ
+	{ AXIS_Y, AXIS_Z, AXIS_X }, // EULER_MODE_YZX
+	{ AXIS_Z, AXIS_X, AXIS_Y }, // EULER_MODE_ZXY
+	{ AXIS_Z, AXIS_Y, AXIS_X }  // EULER_MODE_ZYX
+};
+
+//--------------------------------------------------------------------------------------------------
+// prototypes
+//--------------------------------------------------------------------------------------------------
+
+static float wrapDegrees( float );
+static Quat axisQuat( int, float );
+static Quat quatLog( Quat );
+static Quat quatExp( Quat );
+static float eulerDistance( const float*, const float* );
+
+//--------------------------------------------------------------------------------------------------
+// functions
+//--------------------------------------------------------------------------------------------------
+
+float wrapDegrees( float angle )
+{
+	angle = fmodf( angle + 180.0f, 360.0f );
+	return (angle < 0.0f ? angle + 360.0f : angle) - 180.0f;
+}
+
+Quat axisQuat( int axis, float degrees )
+{
+	float half = degrees * DEG_TO_RAD * 0.5f;
+	Quat q = { cosf( half ), 0.0f, 0.0f, 0.0f };
+	float s = sinf( half );
+	q.x = axis == AXIS_X ? s : 0.0f;
+	q.y = axis == AXIS_Y ? s : 0.0f;
+	q.z = axis == AXIS_Z ? s : 0.0f;
+	return q;
+}
+
+Quat quatLog( Quat q )
+{
+	// log of a unit quaternion is the pure quaternion of half its rotation about its axis
+	float length = sqrtf( q.x * q.x + q.y * q.y + q.z * q.z );
+	float scale = length > SLERP_EPSILON ? atan2f( length, q.w ) / length : 1.0f;
+	Quat result = { 0.0f, q.x * scale, q.y * scale, q.z * scale };
+	return result;
+}
+
+Quat quatExp( Quat q )
+{
+	float angle = sqrtf( q.x * q.x + q.y * q.y + q.z * q.z );
+	float scale = angle > SLERP_EPSILON ? sinf( angle ) / angle : 1.0f;
+	Quat result = { cosf( angle ), q.x * scale, q.y * scale, q.z * scale };
+	return result;
+}
+
+float eulerDistance( const float* a, const float* b )
+{
+	return fabsf( wrapDegrees( a[0] - b[0] ) ) + fabsf( wrapDegrees( a[1] - b[1] ) ) + fabsf( wrapDegrees( a[2] - b[2] ) );
+}
+
+Quat quatMultiply(Quat a, Quat b)
+{
+	Quat result = {
+		a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+		a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+		a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+		a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w
+	};
+	return result;
+}
+
+Quat quatConjugate(Quat q)
+{
+	Quat result = { q.w, -q.x, -q.y, -q.z };
+	return result;
+}
+
+float quatDot(Quat a, Quat b)
+{
+	return a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+Quat slerpQuat(Quat a, Quat b, float t)
+{
+	// follows the arc between a and b as given, callers pick the hemisphere
+	float d = quatDot( a, b );
+	d = d > 1.0f ? 1.0f : (d < -1.0f ? -1.0f : d);
+	float theta = acosf( d );
+	float sine = sinf( theta );
+	float wa = sine > SLERP_EPSILON ? sinf( (1.0f - t) * theta ) / sine : 1.0f - t;
+	float wb = sine > SLERP_EPSILON ? sinf( t * theta ) / sine : t;
+
+	Quat result = {
+		wa * a.w + wb * b.w,
+		wa * a.x + wb * b.x,
+		wa * a.y + wb * b.y,
+		wa * a.z + wb * b.z
+	};
+	return result;
+}
+
+Quat eulerToQuat(const float rotation[3], enum EulerMode eulerMode)
+{
+	const int* order = applyOrder[eulerMode];
+	Quat first = axisQuat( order[0], rotation[order[0]] );
+	Quat second = axisQuat( order[1], rotation[order[1]] );
+	Quat third = axisQuat( order[2], rotation[order[2]] );
+	return quatMultiply( third, quatMultiply( second, first ) );
+}
+
+void quatToEuler(Quat q, enum EulerMode eulerMode, const float reference[3], float rotation[3])
+{
+	float m[3][3] = {
+		{ 1.0f - 2.0f * (q.y * q.y + q.z * q.z), 2.0f * (q.x * q.y - q.w * q.z), 2.0f * (q.x * q.z + q.w * q.y) },
+		{ 2.0f * (q.x * q.y + q.w * q.z), 1.0f - 2.0f * (q.x * q.x + q.z * q.z), 2.0f * (q.y * q.z - q.w * q.x) },
+		{ 2.0f * (q.x * q.z - q.w * q.y), 2.0f * (q.y * q.z + q.w * q.x), 1.0f - 2.0f * (q.x * q.x + q.y * q.y) }
+	};
+
+	// the matrix is R(k) R(j) R(i) with i applied first, odd orders flip the off-diagonal signs
+	const int* order = applyOrder[eulerMode];
+	int i = order[0], j = order[1], k = order[2];
+	float parity = (j - i + 3) % 3 == 1 ? 1.0f : -1.0f;
+
+	float sineJ = -parity * m[k][i];
+	sineJ = sineJ > 1.0f ? 1.0f : (sineJ < -1.0f ? -1.0f : sineJ);
+	float a[3], b[3];
+	a[j] = asinf( sineJ ) * RAD_TO_DEG;
+	if ( fabsf( sineJ ) < 0.9999f )
+	{
+		a[i] = atan2f( parity * m[k][j], m[k][k] ) * RAD_TO_DEG;
+		a[k] = atan2f( parity * m[j][i], m[i][i] ) * RAD_TO_DEG;
+	}
+	else
+	{
+		// gimbal lock, the first and last axes coincide so put all of it on the first
+		a[i] = atan2f( -parity * m[j][k], m[j][j] ) * RAD_TO_DEG;
+		a[k] = 0.0f;
+	}
+
+	// the same orientation with the middle axis turned past 90 degrees
+	b[i] = wrapDegrees( a[i] + 180.0f );
+	b[j] = wrapDegrees( 180.0f - a[j] );
+	b[k] = wrapDegrees( a[k] + 180.0f );
+	a[i] = wrapDegrees( a[i] );
+	a[j] = wrapDegrees( a[j] );
+	a[k] = wrapDegrees( a[k] );
+
+	const float* best = reference != NULL && eulerDistance( b, reference ) < eulerDistance( a, reference ) ? b : a;
+	rotation[0] = best[0];
+	rotation[1] = best[1];
+	rotation[2] = best[2];
+}
+
+void eulerAxis(const float rotation[3], enum EulerMode eulerMode, enum Axis axis, float direction[3])
+{
+	const int* order = applyOrder[eulerMode];
+	Quat outer = { 1.0f, 0.0f, 0.0f, 0.0f };
+	for ( int i = 2; i >= 0 && order[i] != (int)axis; --i )
+	{
+		outer = quatMultiply( outer, axisQuat( order[i], rotation[order[i]] ) );
+	}
+
+	Quat unit = { 0.0f, axis == AXIS_X ? 1.0f : 0.0f, axis == AXIS_Y ? 1.0f : 0.0f, axis == AXIS_Z ? 1.0f : 0.0f };
+	Quat turned = quatMultiply( quatMultiply( outer, unit ), quatConjugate( outer ) );
+	direction[0] = turned.x;
+	direction[1] = turned.y;
+	direction[2] = turned.z;
+}
+
+void squadControls(Quat previous, Quat q, Quat next, float before, float after, Quat* incoming, Quat* outgoing)
+{
+	// keep the neighbours in q's hemisphere so the control points follow the shorter arcs
+	if ( quatDot( previous, q ) < 0.0f )
+	{
+		previous = (Quat){ -previous.w, -previous.x, -previous.y, -previous.z };
+	}
+	if ( quatDot( next, q ) < 0.0f )
+	{
+		next = (Quat){ -next.w, -next.x, -next.y, -next.z };
+	}
+
+	Quat inverse = quatConjugate( q );
+	Quat toNext = quatLog( quatMultiply( inverse, next ) );
+	Quat toPrevious = quatLog( quatMultiply( inverse, previous ) );
+
+	// the rate of turn through q is the central difference over the time between the neighbours, and
+	// each segment is scaled to its own length so it leaves or arrives at that rate; with even
+	// spacing both reduce to the usual -(toNext + toPrevious) / 4
+	float span = before + after;
+	float rate[3] = { 0.0f, 0.0f, 0.0f };
+	if ( span > 0.0f )
+	{
+		rate[0] = (toNext.x - toPrevious.x) / span;
+		rate[1] = (toNext.y - toPrevious.y) / span;
+		rate[2] = (toNext.z - toPrevious.z) / span;
+	}
+	Quat in = {
+		0.0f,
+		-0.5f * (toPrevious.x + before * rate[0]),
+		-0.5f * (toPrevious.y + before * rate[1]),
+		-0.5f * (toPrevious.z + before * rate[2])
+	};
+	Quat out = {
+		0.0f,
+		0.5f * (after * rate[0] - toNext.x),
+		0.5f * (after * rate[1] - toNext.y),
+		0.5f * (after * rate[2] - toNext.z)
+	};
+	*incoming = quatMultiply( q, quatExp( in ) );
+	*outgoing = quatMultiply( q, quatExp( out ) );
+}
+
+Quat squadQuat(Quat q0, Quat q1, Quat s0, Quat s1, float t)
+{
+	return slerpQuat( slerpQuat( q0, q1, t ), slerpQuat( s0, s1, t ), 2.0f * t * (1.0f - t) );
+}
+
+void squadColumns(size_t count, const QuatColumns* q0, const QuatColumns* q1, const QuatColumns* s0, const QuatColumns* s1, const float* t, QuatColumns* out)
+{
+	const float* restrict aw = q0->w; const float* restrict ax = q0->x; const float* restrict ay = q0->y; const float* restrict az = q0->z;
+	const float* restrict bw = q1->w; const float* restrict bx = q1->x; const float* restrict by = q1->y; const float* restrict bz = q1->z;
+	const float* restrict cw = s0->w; const float* restrict cx = s0->x; const float* restrict cy = s0->y; const float* restrict cz = s0->z;
+	const float* restrict dw = s1->w; const float* restrict dx = s1->x; const float* restrict dy = s1->y; const float* restrict dz = s1->z;
+	const float* restrict lt = t;
+	float* restrict ow = out->w; float* restrict ox = out->x; float* restrict oy = out->y; float* restrict oz = out->z;
+
+	for ( size_t li = 0; li < count; ++li )
+	{
+		float u = lt[li];
+
+		// slerp between the keys
+		float d0 = aw[li] * bw[li] + ax[li] * bx[li] + ay[li] * by[li] + az[li] * bz[li];
+		d0 = fminf( fmaxf( d0, -1.0f ), 1.0f );
+		float theta0 = acosf( d0 );
+		float sine0 = sinf( theta0 );
+		float wa0 = sine0 > SLERP_EPSILON ? sinf( (1.0f - u) * theta0 ) / sine0 : 1.0f - u;
+		float wb0 = sine0 > SLERP_EPSILON ? sinf( u * theta0 ) / sine0 : u;
+		float pw = wa0 * aw[li] + wb0 * bw[li];
+		float px = wa0 * ax[li] + wb0 * bx[li];
+		float py = wa0 * ay[li] + wb0 * by[li];
+		float pz = wa0 * az[li] + wb0 * bz[li];
+
+		// slerp between the control points
+		float d1 = cw[li] * dw[li] + cx[li] * dx[li] + cy[li] * dy[li] + cz[li] * dz[li];
+		d1 = fminf( fmaxf( d1, -1.0f ), 1.0f );
+		float theta1 = acosf( d1 );
+		float sine1 = sinf( theta1 );
+		float wa1 = sine1 > SLERP_EPSILON ? sinf( (1.0f - u) * theta1 ) / sine1 : 1.0f - u;
+		float wb1 = sine1 > SLERP_EPSILON ? sinf( u * theta1 ) / sine1 : u;
+		float qw = wa1 * cw[li] + wb1 * dw[li];
+		float qx = wa1 * cx[li] + wb1 * dx[li];
+		float qy = wa1 * cy[li] + wb1 * dy[li];
+		float qz = wa1 * cz[li] + wb1 * dz[li];
+
+		// and between the two
+		float h = 2.0f * u * (1.0f - u);
+		float d2 = pw * qw + px * qx + py * qy + pz * qz;
+		d2 = fminf( fmaxf( d2, -1.0f ), 1.0f );
+		float theta2 = acosf( d2 );
+		float sine2 = sinf( theta2 );
+		float wa2 = sine2 > SLERP_EPSILON ? sinf( (1.0f - h) * theta2 ) / sine2 : 1.0f - h;
+		float wb2 = sine2 > SLERP_EPSILON ? sinf( h * theta2 ) / sine2 : h;
+		ow[li] = wa2 * pw + wb2 * qw;
+		ox[li] = wa2 * px + wb2 * qx;
+		oy[li] = wa2 * py + wb2 * qy;
+		oz[li] = wa2 * pz + wb2 * qz;
+	}
+}
+
+void hermiteColumns(size_t count, const float* p0, const float* p1, const float* m0, const float* m1, const float* t, float* out)
+{
+	const float* restrict a = p0;
+	const float* restrict b = p1;
+	const float* restrict ma = m0;
+	const float* restrict mb = m1;
+	const float* restrict lt = t;
+	float* restrict result = out;
+
+	for ( size_t li = 0; li < count; ++li )
+	{
+		float u = lt[li];
+		float u2 = u * u;
+		float u3 = u2 * u;
+		result[li] = (2.0f * u3 - 3.0f * u2 + 1.0f) * a[li] +
+			(u3 - 2.0f * u2 + u) * ma[li] +
+			(-2.0f * u3 + 3.0f * u2) * b[li] +
+			(u3 - u2) * mb[li];
+	}
+}
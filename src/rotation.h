@@ -0,0 +1,61 @@
+#pragma once
+#include "gimbal.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Quat
+{
+	float w;
+	float x;
+	float y;
+	float z;
+} Quat;
+
+// quaternions stored column by column, one lane per array element
+typedef struct QuatColumns
+{
+	float* w;
+	float* x;
+	float* y;
+	float* z;
+} QuatColumns;
+
+//--------------------------------------------------------------------------------------------------
+// quaternions
+//--------------------------------------------------------------------------------------------------
+
+Quat quatMultiply(Quat a, Quat b);
+Quat quatConjugate(Quat q);
+float quatDot(Quat a, Quat b);
+Quat slerpQuat(Quat a, Quat b, float t);
+
+// euler angles in degrees, composed in the same order drawGimbal applies them
+Quat eulerToQuat(const float rotation[3], enum EulerMode eulerMode);
+// of the two angle sets giving the same orientation, returns the one closest to the reference so
+// a sampled path doesn't flip between them
+void quatToEuler(Quat q, enum EulerMode eulerMode, const float reference[3], float rotation[3]);
+// the world direction of one axis's ring, which only the rotations applied after that axis turn
+void eulerAxis(const float rotation[3], enum EulerMode eulerMode, enum Axis axis, float direction[3]);
+
+//--------------------------------------------------------------------------------------------------
+// splines
+//--------------------------------------------------------------------------------------------------
+
+// inner control points of a SQUAD spline at q, for the segments arriving at and leaving it, given the
+// keys either side and how long before and after q they are; the spline passes through q at the same
+// rate from both sides however unevenly the keys are spaced
+void squadControls(Quat previous, Quat q, Quat next, float before, float after, Quat* incoming, Quat* outgoing);
+Quat squadQuat(Quat q0, Quat q1, Quat s0, Quat s1, float t);
+
+// Spline kernels over many lanes at once, e.g. many gimbals or many time samples. Every lane runs
+// the same branch-free arithmetic on contiguous columns, so the loops vectorise.
+void squadColumns(size_t count, const QuatColumns* q0, const QuatColumns* q1, const QuatColumns* s0, const QuatColumns* s1, const float* t, QuatColumns* out);
+// cubic hermite from p0 to p1, with tangents already scaled to the segment length
+void hermiteColumns(size_t count, const float* p0, const float* p1, const float* m0, const float* m1, const float* t, float* out);
+
+#ifdef __cplusplus
+}
+#endif
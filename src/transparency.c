@@ -0,0 +1,213 @@
+#include "transparency.h"
+#include "extensions.h"
+#include "layers.h"
+
+//--------------------------------------------------------------------------------------------------
+// shaders
+//--------------------------------------------------------------------------------------------------
+
+// written to two targets: the weighted premultiplied colour, and log(1 - alpha) so that additive
+// blending yields the log of the revealage product; this lets both targets share one blend func
+static const char* accumulateSource =
+	"#version 110\n"
+	"void main()\n"
+	"{\n"
+	"	vec4 color = gl_Color;\n"
+	"	float depth = 1.0 - gl_FragCoord.z;\n"
+	"	float weight = clamp(color.a * max(1e-2, 3e3 * depth * depth * depth), 1e-2, 3e3);\n"
+	"	gl_FragData[0] = vec4(color.rgb * color.a, color.a) * weight;\n"
+	"	gl_FragData[1] = vec4(log(max(1.0 - color.a, 1e-4)));\n"
+	"}\n";
+
+static const char* compositeSource =
+	"#version 110\n"
+	"uniform sampler2D accumTexture;\n"
+	"uniform sampler2D revealTexture;\n"
+	"void main()\n"
+	"{\n"
+	"	float revealage = exp(texture2D(revealTexture, gl_TexCoord[0].st).r);\n"
+	"	if (revealage >= 1.0)\n"
+	"	{\n"
+	"		discard;\n"
+	"	}\n"
+	"	vec4 accum = texture2D(accumTexture, gl_TexCoord[0].st);\n"
+	"	gl_FragColor = vec4(accum.rgb / max(accum.a, 1e-5), 1.0 - revealage);\n"
+	"}\n";
+
+//--------------------------------------------------------------------------------------------------
+// state
+//--------------------------------------------------------------------------------------------------
+
+static bool unsupported = false;
+static GLuint framebuffer = 0;
+static GLuint accumTexture = 0;
+static GLuint revealTexture = 0;
+static GLuint accumulateProgram = 0;
+static GLuint compositeProgram = 0;
+static int targetWidth = 0;
+static int targetHeight = 0;
+static GLuint previousFramebuffer = 0;
+
+//--------------------------------------------------------------------------------------------------
+// prototypes
+//--------------------------------------------------------------------------------------------------
+
+static bool createResources( void );
+static bool resizeTargets( int, int );
+static void allocateTarget( GLuint, int, int );
+
+//--------------------------------------------------------------------------------------------------
+// functions
+//--------------------------------------------------------------------------------------------------
+
+bool createResources( void )
+{
+	if ( !hasShaders() || !hasFramebuffers() || !hasFloatTextures() )
+	{
+		return false;
+	}
+
+	accumulateProgram = createFragmentProgram( accumulateSource );
+	compositeProgram = createFragmentProgram( compositeSource );
+	if ( accumulateProgram == 0 || compositeProgram == 0 )
+	{
+		return false;
+	}
+
+	// the samplers never change so they only need setting once
+	extUseProgram( compositeProgram );
+	extUniform1i( extGetUniformLocation( compositeProgram, "accumTexture" ), 0 );
+	extUniform1i( extGetUniformLocation( compositeProgram, "revealTexture" ), 1 );
+	extUseProgram( 0 );
+
+	glGenTextures( 1, &accumTexture );
+	glGenTextures( 1, &revealTexture );
+	extGenFramebuffers( 1, &framebuffer );
+	return true;
+}
+
+void allocateTarget( GLuint texture, int width, int height )
+{
+	glBindTexture( GL_TEXTURE_2D, texture );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+	glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL );
+}
+
+bool resizeTargets( int width, int height )
+{
+	allocateTarget( accumTexture, width, height );
+	allocateTarget( revealTexture, width, height );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+
+	bindFramebuffer( framebuffer );
+	extFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, accumTexture, 0 );
+	extFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, revealTexture, 0 );
+
+	// draw buffers are framebuffer state, so this only has to be set when attaching
+	const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	extDrawBuffers( 2, drawBuffers );
+
+	bool complete = extCheckFramebufferStatus( GL_FRAMEBUFFER ) == GL_FRAMEBUFFER_COMPLETE;
+	bindFramebuffer( previousFramebuffer );
+
+	targetWidth = width;
+	targetHeight = height;
+	return complete;
+}
+
+bool beginTransparentPass(int width, int height)
+{
+	if ( unsupported || width <= 0 || height <= 0 )
+	{
+		return false;
+	}
+
+	// composite back onto whichever target was bound, e.g. an impostor cache
+	previousFramebuffer = boundFramebuffer();
+
+	if ( accumulateProgram == 0 && !createResources() )
+	{
+		releaseTransparentPass();
+		unsupported = true;
+		return false;
+	}
+
+	if ( (width != targetWidth || height != targetHeight) && !resizeTargets( width, height ) )
+	{
+		releaseTransparentPass();
+		unsupported = true;
+		return false;
+	}
+
+	glPushAttrib( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_ENABLE_BIT );
+	bindFramebuffer( framebuffer );
+
+	// zero is both an empty accumulation and log(1), i.e. fully revealed
+	glClearColor( 0.0f, 0.0f, 0.0f, 0.0f );
+	glClear( GL_COLOR_BUFFER_BIT );
+
+	// surfaces don't occlude each other, they all contribute to the weighted average
+	glDisable( GL_DEPTH_TEST );
+	glDepthMask( GL_FALSE );
+	glEnable( GL_BLEND );
+	glBlendFunc( GL_ONE, GL_ONE );
+
+	extUseProgram( accumulateProgram );
+	return true;
+}
+
+void endTransparentPass(void)
+{
+	bindFramebuffer( previousFramebuffer );
+	extUseProgram( compositeProgram );
+
+	extActiveTexture( GL_TEXTURE1 );
+	glBindTexture( GL_TEXTURE_2D, revealTexture );
+	extActiveTexture( GL_TEXTURE0 );
+	glBindTexture( GL_TEXTURE_2D, accumTexture );
+
+	glDisable( GL_LIGHTING );
+	glDisable( GL_CULL_FACE );
+	blendOver();
+	drawFullscreenQuad();
+
+	glBindTexture( GL_TEXTURE_2D, 0 );
+	extActiveTexture( GL_TEXTURE1 );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+	extActiveTexture( GL_TEXTURE0 );
+	extUseProgram( 0 );
+	glPopAttrib();
+}
+
+void releaseTransparentPass(void)
+{
+	if ( framebuffer != 0 )
+	{
+		extDeleteFramebuffers( 1, &framebuffer );
+	}
+	if ( accumTexture != 0 )
+	{
+		glDeleteTextures( 1, &accumTexture );
+	}
+	if ( revealTexture != 0 )
+	{
+		glDeleteTextures( 1, &revealTexture );
+	}
+	if ( accumulateProgram != 0 )
+	{
+		extDeleteProgram( accumulateProgram );
+	}
+	if ( compositeProgram != 0 )
+	{
+		extDeleteProgram( compositeProgram );
+	}
+
+	framebuffer = 0;
+	accumTexture = 0;
+	revealTexture = 0;
+	accumulateProgram = 0;
+	compositeProgram = 0;
+	targetWidth = 0;
+	targetHeight = 0;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Weighted blended order-independent transparency (McGuire & Bavoil, 2013).
+// Every translucent surface drawn between begin/end is accumulated into off-screen float
+// targets with commutative blending, then resolved onto the framebuffer in a single composite.
+// No sorting is needed and the resolve costs the same regardless of how many surfaces were drawn.
+//
+// beginTransparentPass() returns false if the driver lacks shaders, framebuffer objects or float
+// textures, in which case nothing is bound and the caller should fall back to ordinary blending.
+bool beginTransparentPass(int width, int height);
+void endTransparentPass(void);
+void releaseTransparentPass(void);
+
+#ifdef __cplusplus
+}
+#endif